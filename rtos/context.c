@@ -1,73 +1,160 @@
 /**
  * Context switch implementation
+ *
+ * PendSV and SVC are written entirely in embedded assembler, so the compiler never touches R4-R11 between exception
+ * entry and the point where they are saved or restored. The registers in R4-R11 on entry are always the interrupted
+ * task's, whatever the optimization level.
+ *
+ * A context switch by PendSV, with no deferred ISR operations and neither RTOS_STACK_CHECK nor RTOS_MPU_STACK_GUARD,
+ * executes 39 instructions, plus exception entry and return. RTOS_STACK_CHECK adds a call to rtosStackCheck(), and
+ * RTOS_MPU_STACK_GUARD adds 8 instructions.
+ *
+ * The assembly accesses the task state as a byte, since the project builds with enums as small as their values allow
+ * (EnumInt off). The checks below fail the build if the fields it accesses change width or alignment.
+ *
  * @author Andrew Morton, 2018
+ * @author Matt Reynolds
+ * @author Dawson Hemphill
  */
+#include <stddef.h>
+
+#include <LPC17xx.h>
+
 #include "context.h"
+#include "globals.h"
+#include "isr.h"
+#include "stack.h"
+
+/// Fail the build unless the specified condition holds
+#define RTOS_STATIC_ASSERT(name, condition) typedef char name[(condition) ? 1 : -1]
+
+/// The size of the specified TCB field, and whether it is a word-aligned 32-bit field that LDR/STR can access
+#define RTOS_TCB_FIELD_SIZE(field) sizeof(((rtosTaskControlBlock_t*) 0)->field)
+#define RTOS_TCB_FIELD_IS_WORD(field) \
+  (RTOS_TCB_FIELD_SIZE(field) == 4 && offsetof(rtosTaskControlBlock_t, field) % 4 == 0)
+
+RTOS_STATIC_ASSERT(rtos_assert_state_is_byte, RTOS_TCB_FIELD_SIZE(state) == 1);
+RTOS_STATIC_ASSERT(rtos_assert_stack_pointer_is_word, RTOS_TCB_FIELD_IS_WORD(stack_pointer));
+RTOS_STATIC_ASSERT(rtos_assert_stack_base_is_word, RTOS_TCB_FIELD_IS_WORD(stack_base));
+RTOS_STATIC_ASSERT(rtos_assert_list_is_word, RTOS_TCB_FIELD_IS_WORD(list));
+RTOS_STATIC_ASSERT(rtos_assert_next_is_word, RTOS_TCB_FIELD_IS_WORD(next));
+RTOS_STATIC_ASSERT(rtos_assert_prev_is_word, RTOS_TCB_FIELD_IS_WORD(prev));
+RTOS_STATIC_ASSERT(rtos_assert_task_list_size, sizeof(rtosTaskList_t) == 8);  // Queues are indexed with LSL #3
 
 /**
- * Store the current execution context on the stack
+ * SVC (Supervisor Call) ISR
  *
- * @return the final value of the stack pointer
+ * Used to start the first task: restores R4-R11 and the PSP of rtos_running_task, then returns into the task through
+ * its initial exception frame.
  */
-__asm uint32_t rtosStoreContext(void) {
+__asm void SVC_Handler(void) {
   // clang-format off
-  MRS   R0,PSP        // Move PSP coprocessor register to R0
-  STMFD R0!,{R4-R11}  // Push the R4 to R11 registers onto the processor stack (PSP)
-  BX    LR            // Return the value of the stack pointer after pushing R4-R11
+  LDR     R0, =__cpp(&rtos_running_task)
+  LDR     R0, [R0]
+  LDR     R0, [R0, #__cpp(offsetof(rtosTaskControlBlock_t, stack_pointer))]
+  LDMIA   R0!, {R4-R11}                                                       // Pop R4-R11 of the first task
+  MSR     PSP, R0                                                             // The hardware pops the rest on return
+  BX      LR
   // clang-format on
 }
 
 /**
- * Restore the specified execution context from the stack
+ * PendSV ISR
+ *
+ * Runs any kernel operations deferred from ISRs, then performs a context switch if one is required. PendSV is pended
+ * both by the scheduler when it decides to switch tasks, and by ISRs when they defer an operation. The running task
+ * is no longer RUNNING exactly when the scheduler has decided to switch away from it.
  *
- * @param sp the stack pointer from which to pop the context
+ * The incoming task is the head of the highest-priority non-empty ready queue, as returned by
+ * rtosPopReadyTask(rtosGetHighestReadyPriority()). The idle task is always ready, so there always is one.
  */
-__asm void rtosRestoreContext(uint32_t sp) {
+__asm void PendSV_Handler(void) {
   // clang-format off
-  LDMFD R0!,{R4-R11} // Pop the R4-R11 registers off of the stack at the specified stack pointer
-  MSR   PSP,R0       // Move the value of the stack pointer after popping R4-R11 into the processor stack (PSP)
-  BX    LR           // Return
-  // clang-format on
-}
+  PRESERVE8
 
-__asm void popR4(void) {
-  // clang-format off
-  POP {R4}
-  BX    LR
-  // clang-format on
-}
+  // Run any operations deferred from ISRs. The C calls preserve R4-R11, so they still hold the running task's values
+  LDR     R0, =__cpp(&rtos_isr_queue_head)
+  LDR     R1, =__cpp(&rtos_isr_queue_tail)
+  LDR     R0, [R0]
+  LDR     R1, [R1]
+  CMP     R0, R1
+  BEQ     pendsv_check_switch
+  PUSH    {R0, LR}                                                            // Save EXC_RETURN. R0 keeps alignment
+  BL      __cpp(rtosProcessDeferred)
+  POP     {R0, LR}
 
-__asm void pushR4(void) {
-  // clang-format off
-  PUSH {R4}
-  BX    LR
-  // clang-format on
-}
+pendsv_check_switch
+  // Switch only if the scheduler has taken the running task out of the RUNNING state
+  LDR     R3, =__cpp(&rtos_running_task)
+  LDR     R1, [R3]                                                            // R1 = the outgoing task
+  CMP     R1, #0
+  BEQ     pendsv_return
+  LDRB    R2, [R1, #__cpp(offsetof(rtosTaskControlBlock_t, state))]
+  CMP     R2, #__cpp(RTOS_TASK_RUNNING)
+  BEQ     pendsv_return
 
-__asm void popR4R6(void) {
-  // clang-format off
-  POP {R4-R6}
-  BX    LR
-  // clang-format on
-}
+  // Push R4-R11 of the outgoing task below its exception frame, and save its stack pointer. R4-R11 are free from here
+  MRS     R0, PSP
+  STMDB   R0!, {R4-R11}
+  STR     R0, [R1, #__cpp(offsetof(rtosTaskControlBlock_t, stack_pointer))]
 
-__asm void pushR4R6(void) {
-  // clang-format off
-  PUSH {R4-R6}
-  BX    LR
-  // clang-format on
-}
+#if RTOS_STACK_CHECK
+  PUSH    {R3, LR}
+  MOV     R0, R1
+  BL      __cpp(rtosStackCheck)
+  POP     {R3, LR}
+#endif
 
-__asm void popR4R10(void) {
-  // clang-format off
-  POP {R4-R10}
-  BX    LR
-  // clang-format on
-}
+  // Find the highest non-empty ready queue. Its index is priority - RTOS_PRIORITY_IDLE = 31 - CLZ(ready bit vector)
+  LDR     R4, =__cpp(&rtos_ready_priorities)
+  LDR     R5, [R4]                                                            // R5 = the ready bit vector
+  CLZ     R6, R5
+  RSB     R6, R6, #31                                                         // R6 = the queue index
+  LDR     R7, =__cpp(&rtos_ready_tasks)
+  ADD     R7, R7, R6, LSL #3                                                  // R7 = the queue. 8 bytes per queue
 
-__asm void pushR4R10(void) {
-  // clang-format off
-  PUSH {R4-R10}
-  BX    LR
+  // Pop the head of the queue, clearing the queue's bit in the ready bit vector if the queue becomes empty
+  LDR     R0, [R7, #__cpp(offsetof(rtosTaskList_t, head))]                    // R0 = the incoming task
+  LDR     R8, [R0, #__cpp(offsetof(rtosTaskControlBlock_t, next))]
+  MOV     R9, #0
+  STR     R8, [R7, #__cpp(offsetof(rtosTaskList_t, head))]
+  CMP     R8, #0
+  BEQ     pendsv_queue_empty
+  STR     R9, [R8, #__cpp(offsetof(rtosTaskControlBlock_t, prev))]
+  B       pendsv_popped
+pendsv_queue_empty
+  STR     R9, [R7, #__cpp(offsetof(rtosTaskList_t, tail))]
+  MOV     R8, #1
+  LSL     R8, R8, R6
+  BIC     R5, R5, R8
+  STR     R5, [R4]
+pendsv_popped
+  STR     R9, [R0, #__cpp(offsetof(rtosTaskControlBlock_t, list))]
+  STR     R9, [R0, #__cpp(offsetof(rtosTaskControlBlock_t, next))]
+
+  // Make the incoming task the running task
+  MOV     R8, #__cpp(RTOS_TASK_RUNNING)
+  STRB    R8, [R0, #__cpp(offsetof(rtosTaskControlBlock_t, state))]
+  STR     R0, [R3]
+
+#if RTOS_MPU_STACK_GUARD
+  // Move the stack guard to the incoming task. The VALID bit selects the region, so this is a single register write
+  LDR     R8, [R0, #__cpp(offsetof(rtosTaskControlBlock_t, stack_base))]
+  ADD     R8, R8, #__cpp(RTOS_STACK_GUARD_SIZE - 1)
+  BIC     R8, R8, #__cpp(RTOS_STACK_GUARD_SIZE - 1)
+  ORR     R8, R8, #__cpp(MPU_RBAR_VALID_Msk | RTOS_STACK_GUARD_REGION)
+  LDR     R9, =__cpp(MPU_BASE + offsetof(MPU_Type, RBAR))
+  STR     R8, [R9]
+  DSB                                                                         // Ensure the region is in effect before
+  ISB                                                                         // the incoming task runs
+#endif
+
+  // Pop R4-R11 of the incoming task. The hardware pops the rest of its context on return
+  LDR     R0, [R0, #__cpp(offsetof(rtosTaskControlBlock_t, stack_pointer))]
+  LDMIA   R0!, {R4-R11}
+  MSR     PSP, R0
+
+pendsv_return
+  BX      LR
   // clang-format on
 }
@@ -0,0 +1,38 @@
+/**
+ * Kernel critical section implementation
+ *
+ * Critical sections raise BASEPRI rather than setting PRIMASK, so by default ISRs, which may only use the lock-free
+ * FromISR API, are not masked. SysTick and PendSV run at the least urgent priority, so they are masked, and a task in
+ * a critical section is never preempted by another task.
+ *
+ * Critical sections nest. BASEPRI is raised on entry to the outermost section and cleared on exit from it. Only thread
+ * mode code and the kernel exception handlers enter critical sections, and the handlers only run while no task is in
+ * one, so a single nesting count suffices.
+ *
+ * @author Matt Reynolds
+ * @author Dawson Hemphill
+ */
+
+#include "critical.h"
+
+uint32_t rtos_critical_nesting = 0;  // Depth of nested rtosEnterCritical() calls
+
+/**
+ * Enter a kernel critical section, masking SysTick, PendSV and any ISR at or below RTOS_MAX_SYSCALL_INTERRUPT_PRIORITY
+ */
+void rtosEnterCritical(void) {
+  __set_BASEPRI(RTOS_MAX_SYSCALL_INTERRUPT_PRIORITY << (8 - __NVIC_PRIO_BITS));
+  __DSB();
+  __ISB();
+  rtos_critical_nesting++;
+}
+
+/**
+ * Exit a kernel critical section. Interrupts are unmasked on exit from the outermost section
+ */
+void rtosExitCritical(void) {
+  rtos_critical_nesting--;
+  if (rtos_critical_nesting == 0) {
+    __set_BASEPRI(0);
+  }
+}
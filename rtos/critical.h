@@ -0,0 +1,31 @@
+/**
+ * Kernel critical sections
+ * @author Matt Reynolds
+ * @author Dawson Hemphill
+ */
+#ifndef __RTOS_CRITICAL_H
+#define __RTOS_CRITICAL_H
+
+#include <stdint.h>
+
+#include <LPC17xx.h>
+
+/// The NVIC priority of SysTick and PendSV: the least urgent priority, so neither preempts an ISR or each other
+#define RTOS_KERNEL_INTERRUPT_PRIORITY ((1U << __NVIC_PRIO_BITS) - 1)
+
+/// The most urgent NVIC priority masked by kernel critical sections. Kernel state is only modified by tasks, SysTick
+/// and PendSV, so by default only the kernel's own exceptions are masked and ISRs are never delayed by the kernel. No
+/// ISR may call the kernel other than through the lock-free FromISR API, whatever its priority. A more urgent value
+/// also masks application ISRs at or below it. Must be between 1 and RTOS_KERNEL_INTERRUPT_PRIORITY
+#ifndef RTOS_MAX_SYSCALL_INTERRUPT_PRIORITY
+#define RTOS_MAX_SYSCALL_INTERRUPT_PRIORITY RTOS_KERNEL_INTERRUPT_PRIORITY
+#endif
+
+#if RTOS_MAX_SYSCALL_INTERRUPT_PRIORITY < 1 || RTOS_MAX_SYSCALL_INTERRUPT_PRIORITY > (1 << __NVIC_PRIO_BITS) - 1
+#error "RTOS_MAX_SYSCALL_INTERRUPT_PRIORITY must be between 1 and RTOS_KERNEL_INTERRUPT_PRIORITY"
+#endif
+
+void rtosEnterCritical(void);
+void rtosExitCritical(void);
+
+#endif  // __RTOS_CRITICAL_H
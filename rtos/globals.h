@@ -6,20 +6,29 @@
 #ifndef __RTOS_GLOBALS_H
 #define __RTOS_GLOBALS_H
 
+#include <stdbool.h>
 #include <stdint.h>
 
+#include "mempool.h"    // For rtosMemPoolHandle_t
 #include "scheduler.h"  // For RTOS_PRIORITY_COUNT
 #include "semaphore.h"  // For rtosSemaphoreHandle_t
 #include "mutex.h"      // For rtosMutexHandle_t
 #include "task.h"       // For rtosTaskControlBlock_t, rtosTaskHandle_t, MAX_TASKS
+#include "timeout.h"
 
-extern uint32_t               rtos_ticks;                             // Defined in rtos.c
+extern rtosTicks_t            rtos_ticks;                             // Defined in rtos.c
+extern rtosTaskHandle_t       rtos_idle_task;                         // Defined in rtos.c
 extern rtosTaskControlBlock_t rtos_tasks[MAX_TASKS];                  // Defined in task.c
 extern rtosSemaphoreHandle_t  rtos_semaphores;                        // Defined in semaphore.c
 extern rtosMutexHandle_t      rtos_mutexes;                           // Defined in mutex.c
-extern rtosTaskHandle_t       rtos_inactive_tasks;                    // Defined in scheduler.c
-extern rtosTaskHandle_t       rtos_ready_tasks[RTOS_PRIORITY_COUNT];  // Defined in scheduler.c
+extern rtosMemPoolHandle_t    rtos_mempools;                          // Defined in mempool.c
+extern rtosTaskList_t         rtos_inactive_tasks;                    // Defined in scheduler.c
+extern rtosTaskList_t         rtos_ready_tasks[RTOS_PRIORITY_COUNT];  // Defined in scheduler.c
+extern uint32_t               rtos_ready_priorities;                  // Defined in scheduler.c
+extern bool                   rtos_reschedule_pending;                // Defined in scheduler.c
 extern rtosTaskHandle_t       rtos_running_task;                      // Defined in scheduler.c
-extern rtosTaskHandle_t       rtos_delayed_tasks;                     // Defined in scheduler.c
+extern rtosTaskHandle_t       rtos_delayed_tasks;                     // Defined in timeout.c
+extern volatile uint32_t      rtos_isr_queue_head;                    // Defined in isr.c
+extern volatile uint32_t      rtos_isr_queue_tail;                    // Defined in isr.c
 
 #endif  // __RTOS_GLOBALS_H
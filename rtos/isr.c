@@ -0,0 +1,73 @@
+/**
+ * Deferred kernel call implementation
+ *
+ * ISRs must not touch the kernel's task lists directly, nor call any other kernel API, since they may interrupt a task,
+ * SysTick or PendSV part way through modifying them. Instead, the FromISR API functions push the operation into a
+ * lock-free ring buffer and pend PendSV. PendSV runs at the lowest exception priority, so it drains the buffer only
+ * once every ISR has returned, and before any task resumes.
+ *
+ * Any number of (nested) ISRs may push concurrently: slots are claimed with LDREX/STREX. Only PendSV pops. Since no
+ * ISR can be preempted by PendSV, every claimed slot has been fully written by the time PendSV reads it.
+ *
+ * @author Matt Reynolds
+ * @author Dawson Hemphill
+ */
+
+#include <LPC17xx.h>
+
+#include "isr.h"
+
+/// A deferred kernel call
+typedef struct {
+  rtosDeferredFunc_t func;
+  void*              object;
+} rtosDeferredCall_t;
+
+rtosDeferredCall_t rtos_isr_queue[RTOS_ISR_QUEUE_SIZE];
+volatile uint32_t  rtos_isr_queue_head = 0;  // Total number of slots ever claimed by ISRs
+volatile uint32_t  rtos_isr_queue_tail = 0;  // Total number of slots ever drained by PendSV
+
+/**
+ * Defer the specified kernel operation until PendSV
+ *
+ * Safe to call from any ISR.
+ *
+ * @param func    The operation to perform
+ * @param object  The argument to pass to the operation
+ *
+ * @return  - RTOS_OK               on success
+ *          - RTOS_ERROR_RESOURCE   if the queue of deferred operations is full
+ */
+rtosStatus_t rtosDeferFromISR(rtosDeferredFunc_t func, void* object) {
+
+  // Claim a slot
+  uint32_t head;
+  do {
+    head = __LDREXW(&rtos_isr_queue_head);
+    if (head - rtos_isr_queue_tail >= RTOS_ISR_QUEUE_SIZE) {
+      __CLREX();
+      return RTOS_ERROR_RESOURCE;
+    }
+  } while (__STREXW(head + 1, &rtos_isr_queue_head) != 0);
+
+  // Fill the slot, and ensure it is written before PendSV can run
+  rtos_isr_queue[head & (RTOS_ISR_QUEUE_SIZE - 1)].func   = func;
+  rtos_isr_queue[head & (RTOS_ISR_QUEUE_SIZE - 1)].object = object;
+  __DMB();
+
+  SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+  return RTOS_OK;
+}
+
+/**
+ * Run every deferred kernel operation, in the order they were deferred
+ *
+ * Called from PendSV only.
+ */
+void rtosProcessDeferred(void) {
+  while (rtos_isr_queue_tail != rtos_isr_queue_head) {
+    rtosDeferredCall_t call = rtos_isr_queue[rtos_isr_queue_tail & (RTOS_ISR_QUEUE_SIZE - 1)];
+    rtos_isr_queue_tail++;
+    call.func(call.object);
+  }
+}
@@ -0,0 +1,22 @@
+/**
+ * Deferred kernel calls from interrupt handlers
+ * @author Matt Reynolds
+ * @author Dawson Hemphill
+ */
+#ifndef __RTOS_ISR_H
+#define __RTOS_ISR_H
+
+#include <stdint.h>
+
+#include "status.h"
+
+/// The maximum number of kernel calls that ISRs can defer before PendSV drains them. Must be a power of two
+#define RTOS_ISR_QUEUE_SIZE 16
+
+/// A kernel operation deferred from an ISR, and run from PendSV
+typedef void (*rtosDeferredFunc_t)(void* object);
+
+rtosStatus_t rtosDeferFromISR(rtosDeferredFunc_t func, void* object);
+void         rtosProcessDeferred(void);
+
+#endif  // __RTOS_ISR_H
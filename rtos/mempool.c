@@ -0,0 +1,296 @@
+/**
+ * Fixed-block memory pool implementation
+ *
+ * Each pool divides caller-provided storage into equal blocks. Free blocks are kept in a singly-linked list threaded
+ * through their first word, so allocating and freeing a block are both O(1) and never fragment the pool. When a block
+ * is freed while tasks are waiting, it is handed directly to the first waiting task.
+ *
+ * ISRs never touch the free list, so rtosMemPoolFreeFromISR() is safe at any interrupt priority. Instead, they push
+ * blocks onto a second list with LDREX/STREX. The next allocation that finds the free list empty moves them onto it, as
+ * does PendSV on behalf of waiting tasks.
+ *
+ * @author Matt Reynolds
+ * @author Dawson Hemphill
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "globals.h"
+#include "mempool.h"
+#include "rtos.h"
+
+rtosMemPoolHandle_t rtos_mempools = NULL;
+
+/**
+ * Take a block from the free list of the specified pool. Must be called from within a critical section
+ *
+ * @returns The block, or NULL if the pool has no free blocks
+ */
+static void* rtosMemPoolPop(rtosMemPoolHandle_t pool) {
+  void* block = pool->free_list;
+  if (block != NULL) {
+    pool->free_list = *(void**) block;
+  }
+  return block;
+}
+
+/**
+ * Return a block to the free list of the specified pool. Must be called from within a critical section
+ */
+static void rtosMemPoolPush(rtosMemPoolHandle_t pool, void* block) {
+  *(void**) block = pool->free_list;
+  pool->free_list = block;
+}
+
+/**
+ * Move the blocks freed from ISRs onto the free list of the specified pool. Must be called from within a critical
+ * section
+ *
+ * ISRs are not masked by the critical section, so the list is taken with an exclusive swap.
+ */
+static void rtosMemPoolReclaim(rtosMemPoolHandle_t pool) {
+  volatile uint32_t* isr_free = (volatile uint32_t*) &pool->isr_free;
+  void*              block;
+  do {
+    block = (void*) __LDREXW(isr_free);
+    if (block == NULL) {
+      __CLREX();
+      return;
+    }
+  } while (__STREXW(0, isr_free) != 0);
+
+  while (block != NULL) {
+    void* next = *(void**) block;
+    rtosMemPoolPush(pool, block);
+    block = next;
+  }
+}
+
+/**
+ * Check whether the specified block was allocated from the specified pool
+ */
+static bool rtosMemPoolOwns(rtosMemPoolHandle_t pool, void* block) {
+  const uint32_t offset = (uint8_t*) block - pool->mem;
+  return (uint8_t*) block >= pool->mem && offset < pool->block_count * pool->block_size
+         && offset % pool->block_size == 0;
+}
+
+/**
+ * Create a new memory pool
+ *
+ * With RTOS_MEMPOOL_PRIO_ORDER, blocked tasks receive free blocks in order of priority rather than in FIFO order.
+ *
+ * @param block_count The number of blocks in the pool
+ * @param block_size  The size of each block, in bytes. Rounded up to a whole number of words
+ * @param attrs       The pool attributes, including its storage
+ * @param pool        The memory pool object to initialize
+ *
+ * @return  - RTOS_OK               on success
+ *          - RTOS_ERROR_PARAMETER  if the pool, attributes or storage are NULL or invalid
+ */
+rtosStatus_t rtosMemPoolNew(uint32_t                 block_count,
+                            uint32_t                 block_size,
+                            const rtosMemPoolAttr_t* attrs,
+                            rtosMemPoolHandle_t      pool) {
+
+  // Ensure the pool handle and storage are valid
+  if (pool == NULL || attrs == NULL || attrs->mem == NULL || ((uint32_t) attrs->mem & 3) != 0 || block_count == 0
+      || attrs->mem_size < RTOS_MEMPOOL_MEM_SIZE(block_count, block_size)) {
+    return RTOS_ERROR_PARAMETER;
+  }
+
+  // Initialize the pool struct fields
+  pool->name        = attrs->name;
+  pool->block_size  = RTOS_MEMPOOL_BLOCK_SIZE(block_size);
+  pool->block_count = block_count;
+  pool->mem         = (uint8_t*) attrs->mem;
+  pool->free_list   = NULL;
+  pool->isr_free    = NULL;
+  rtosWaitQueueInit(&pool->blocked, attrs->attr_bits & RTOS_MEMPOOL_PRIO_ORDER);
+
+  // Link the blocks into the free list, so that they are allocated in address order
+  for (uint32_t i = block_count; i > 0; i--) {
+    rtosMemPoolPush(pool, pool->mem + (i - 1) * pool->block_size);
+  }
+
+  // Add the pool to the global list of memory pools
+  rtosEnterCritical();
+  pool->next    = rtos_mempools;
+  rtos_mempools = pool;
+  rtosExitCritical();
+
+  return RTOS_OK;
+}
+
+/**
+ * Delete the specified memory pool object
+ *
+ * Blocks that are still allocated must no longer be used, nor freed, including from ISRs.
+ *
+ * @return  - RTOS_OK               on success
+ *          - RTOS_ERROR_PARAMETER  if the pool is NULL or invalid
+ */
+rtosStatus_t rtosMemPoolDelete(rtosMemPoolHandle_t pool) {
+
+  // Ensure the pool handle is valid
+  if (pool == NULL) {
+    return RTOS_ERROR_PARAMETER;
+  }
+
+  rtosEnterCritical();
+
+  // Remove the pool from the global list of memory pools
+  rtosMemPoolHandle_t* link = &rtos_mempools;
+  while (*link != NULL && *link != pool) {
+    link = &(*link)->next;
+  }
+  if (*link != NULL) {
+    *link = pool->next;
+  }
+
+  // Unblock all blocked tasks
+  // NOTE: Tasks unblocked via pool deletion return RTOS_ERROR since no block became available
+  while (pool->blocked.list.head != NULL) {
+    rtosUnblockTask(pool->blocked.list.head, RTOS_ERROR);
+  }
+  pool->free_list = NULL;
+  pool->isr_free  = NULL;
+
+  rtosExitCritical();
+  rtosInvokeScheduler();
+
+  return RTOS_OK;
+}
+
+/**
+ * Allocate a block from the specified memory pool
+ *
+ * @param timeout The number of ticks to wait for a free block, 0 to not wait, or RTOS_WAIT_FOREVER
+ * @param block   Set to the allocated block on success, or NULL otherwise
+ *
+ * @return  - RTOS_OK               on success
+ *          - RTOS_ERROR            if the pool was deleted, or the task was suspended, while waiting for a block
+ *          - RTOS_ERROR_TIMEOUT    if no block became free in the specified timeout
+ *          - RTOS_ERROR_PARAMETER  if the pool or block is NULL or invalid
+ *          - RTOS_ERROR_RESOURCE   if no block was free and no timeout was specified
+ */
+rtosStatus_t rtosMemPoolAlloc(rtosMemPoolHandle_t pool, uint32_t timeout, void** block) {
+
+  // Ensure the pool handle is valid
+  if (pool == NULL || block == NULL) {
+    return RTOS_ERROR_PARAMETER;
+  }
+
+  rtosEnterCritical();
+
+  // If a block is free, take it. If not, collect any blocks freed from ISRs first
+  if (pool->free_list == NULL) {
+    rtosMemPoolReclaim(pool);
+  }
+  *block = rtosMemPoolPop(pool);
+  if (*block != NULL) {
+    rtosExitCritical();
+    return RTOS_OK;
+  }
+
+  // Timeout value is set to zero so don't wait
+  if (timeout == 0) {
+    rtosExitCritical();
+    return RTOS_ERROR_RESOURCE;
+  }
+
+  // Otherwise, block the current task until a free hands it a block, the timeout expires, or the pool is deleted
+  if (timeout == RTOS_WAIT_FOREVER) {
+    rtos_running_task->state = RTOS_TASK_BLOCKED;
+  } else {
+    rtos_running_task->state = RTOS_TASK_BLOCKED_TIMEOUT;
+    rtosTimeoutInsert(rtos_running_task, rtos_ticks + timeout);
+  }
+  rtos_running_task->wake_data = NULL;
+  rtosWaitQueueInsert(&pool->blocked, rtos_running_task);
+
+  rtosExitCritical();
+  rtosInvokeScheduler();
+
+  // A free hands its block directly to the woken task
+  *block = rtos_running_task->wake_data;
+  return rtos_running_task->wake_status;
+}
+
+/**
+ * Return a block to the specified memory pool
+ *
+ * @return  - RTOS_OK               on success
+ *          - RTOS_ERROR_PARAMETER  if the pool is NULL or invalid, or the block does not belong to the pool
+ */
+rtosStatus_t rtosMemPoolFree(rtosMemPoolHandle_t pool, void* block) {
+
+  // Ensure the pool handle and block are valid
+  if (pool == NULL || block == NULL || !rtosMemPoolOwns(pool, block)) {
+    return RTOS_ERROR_PARAMETER;
+  }
+
+  rtosEnterCritical();
+
+  // If there are blocked tasks, hand the block directly to the first task in the queue. Otherwise, free it
+  if (pool->blocked.list.head != NULL) {
+    pool->blocked.list.head->wake_data = block;
+    rtosUnblockTask(pool->blocked.list.head, RTOS_OK);
+
+    rtosExitCritical();
+    rtosInvokeScheduler();
+    return RTOS_OK;
+  }
+
+  rtosMemPoolPush(pool, block);
+  rtosExitCritical();
+  return RTOS_OK;
+}
+
+/**
+ * Return the blocks freed from ISRs to the specified pool, handing them to any waiting tasks, once PendSV runs
+ */
+static void rtosMemPoolReclaimDeferred(void* object) {
+  rtosMemPoolHandle_t pool = (rtosMemPoolHandle_t) object;
+
+  rtosEnterCritical();
+  rtosMemPoolReclaim(pool);
+  while (pool->blocked.list.head != NULL && pool->free_list != NULL) {
+    pool->blocked.list.head->wake_data = rtosMemPoolPop(pool);
+    rtosUnblockTask(pool->blocked.list.head, RTOS_OK);
+  }
+  rtosExitCritical();
+
+  rtosInvokeScheduler();
+}
+
+/**
+ * Return a block to the specified memory pool from an ISR
+ *
+ * Safe to call from any ISR, at any priority, since the block is pushed onto the pool's list of blocks freed from ISRs
+ * without a critical section. Returning it to the free list, and handing it
+ * to a waiting task, is deferred to PendSV, which runs as soon as every active ISR has returned.
+ *
+ * @return  - RTOS_OK               on success
+ *          - RTOS_ERROR_RESOURCE   if the block was freed, but too many operations have been deferred from ISRs since
+ *                                  PendSV last ran to wake a waiting task. The next free wakes it instead
+ *          - RTOS_ERROR_PARAMETER  if the pool is NULL or invalid, or the block does not belong to the pool
+ */
+rtosStatus_t rtosMemPoolFreeFromISR(rtosMemPoolHandle_t pool, void* block) {
+
+  // Ensure the pool handle and block are valid
+  if (pool == NULL || block == NULL || !rtosMemPoolOwns(pool, block)) {
+    return RTOS_ERROR_PARAMETER;
+  }
+
+  // Push the block onto the list of blocks freed from ISRs. A nested ISR that pushes in between fails the store
+  volatile uint32_t* isr_free = (volatile uint32_t*) &pool->isr_free;
+  do {
+    *(void**) block = (void*) __LDREXW(isr_free);
+  } while (__STREXW((uint32_t) block, isr_free) != 0);
+
+  // A task may begin waiting at any time, so always defer the reclaim rather than checking for blocked tasks here
+  return rtosDeferFromISR(rtosMemPoolReclaimDeferred, pool);
+}
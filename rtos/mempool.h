@@ -0,0 +1,55 @@
+/**
+ * Fixed-block memory pools
+ * @author Matt Reynolds
+ * @author Dawson Hemphill
+ */
+#ifndef __RTOS_MEMPOOL_H
+#define __RTOS_MEMPOOL_H
+
+#include <stdint.h>
+
+#include "status.h"
+#include "task.h"
+#include "waitqueue.h"
+
+// Define memory pool attribute options
+#define RTOS_MEMPOOL_PRIO_ORDER 0x00000010U
+
+/// The size of each block in a pool with the specified block size, in bytes. Blocks are word-aligned
+#define RTOS_MEMPOOL_BLOCK_SIZE(block_size) ((block_size) < 4U ? 4U : (((block_size) + 3U) & ~3U))
+
+/// The number of bytes of storage required by a pool of the specified number and size of blocks
+#define RTOS_MEMPOOL_MEM_SIZE(block_count, block_size) ((block_count) * RTOS_MEMPOOL_BLOCK_SIZE(block_size))
+
+/// Memory pool attributes
+typedef struct {
+  const char* name;
+  uint32_t    attr_bits;
+  void*       mem;       ///< The storage for the blocks. Must be word-aligned. Declare with RTOS_AHB_SRAM to use IRAM2
+  uint32_t    mem_size;  ///< The size of the storage, in bytes. At least RTOS_MEMPOOL_MEM_SIZE(block_count, block_size)
+} rtosMemPoolAttr_t;
+
+/// Memory pool
+typedef struct rtosMemPool_tag {
+  const char*             name;         ///< The name of memory pool
+  uint32_t                block_size;   ///< The size of each block, in bytes
+  uint32_t                block_count;  ///< The number of blocks in the pool
+  uint8_t*                mem;          ///< The storage for the blocks
+  void*                   free_list;    ///< The free blocks, each linked through its first word
+  void* volatile          isr_free;     ///< The blocks freed from ISRs and not yet returned to the free list
+  rtosWaitQueue_t         blocked;      ///< The tasks blocked waiting for a free block
+  struct rtosMemPool_tag* next;         ///< The next memory pool in the global list
+} rtosMemPool_t;
+
+typedef rtosMemPool_t* rtosMemPoolHandle_t;
+
+rtosStatus_t rtosMemPoolNew(uint32_t                 block_count,
+                            uint32_t                 block_size,
+                            const rtosMemPoolAttr_t* attrs,
+                            rtosMemPoolHandle_t      pool);
+rtosStatus_t rtosMemPoolDelete(rtosMemPoolHandle_t pool);
+rtosStatus_t rtosMemPoolAlloc(rtosMemPoolHandle_t pool, uint32_t timeout, void** block);
+rtosStatus_t rtosMemPoolFree(rtosMemPoolHandle_t pool, void* block);
+rtosStatus_t rtosMemPoolFreeFromISR(rtosMemPoolHandle_t pool, void* block);
+
+#endif  // __RTOS_MEMPOOL_H
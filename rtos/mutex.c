@@ -4,6 +4,7 @@
  * @author Dawson Hemphill
  */
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
 
@@ -13,14 +14,192 @@
 
 rtosMutexHandle_t rtos_mutexes = NULL;
 
+/// The owner of every mutex abandoned by a deleted task. An abandoned mutex can never be acquired again, only deleted
+static rtosTaskControlBlock_t rtos_mutex_abandoned;
+
+/**
+ * Compute the effective priority of the specified task
+ *
+ * This is the task's base priority, raised to the ceiling of any priority-ceiling mutex the task holds, and to the
+ * priority of the highest-priority task blocked on any priority-inheritance mutex the task holds.
+ */
+rtosPriority_t rtosMutexEffectivePriority(rtosTaskHandle_t task) {
+  rtosPriority_t priority = task->base_priority;
+  for (rtosMutexHandle_t mutex = task->held_mutexes; mutex != NULL; mutex = mutex->held_next) {
+    if (mutex->ceiling > priority) {
+      priority = mutex->ceiling;
+    }
+    if (mutex->attr_bits & RTOS_MUTEX_PRIO_INHERIT) {
+      rtosPriority_t waiter_priority = rtosWaitQueueHighestPriority(&mutex->blocked);
+      if (waiter_priority > priority) {
+        priority = waiter_priority;
+      }
+    }
+  }
+  return priority;
+}
+
+/**
+ * Raise the owner of the specified mutex to at least the specified priority, and propagate the boost along the chain
+ *
+ * If the owner is itself blocked on a priority-inheritance mutex, that mutex's owner is boosted too, and so on. The
+ * walk stops at the first owner that already has the priority, so the cost is bounded by the length of the chain.
+ */
+static void rtosMutexBoostOwners(rtosMutexHandle_t mutex, rtosPriority_t priority) {
+  while (mutex != NULL && (mutex->attr_bits & RTOS_MUTEX_PRIO_INHERIT) && mutex->acquired != NULL
+         && mutex->acquired->priority < priority) {
+    rtosChangeTaskPriority(mutex->acquired, priority);
+    mutex = mutex->acquired->blocked_on;
+  }
+}
+
+/**
+ * Recompute the priority of the owner of the specified mutex after a task stopped waiting on it, and propagate any
+ * change along the chain of owners
+ */
+static void rtosMutexUpdateOwners(rtosMutexHandle_t mutex) {
+  while (mutex != NULL && mutex->acquired != NULL) {
+    rtosTaskHandle_t owner    = mutex->acquired;
+    rtosPriority_t   priority = rtosMutexEffectivePriority(owner);
+    if (priority == owner->priority) {
+      break;
+    }
+    rtosChangeTaskPriority(owner, priority);
+    mutex = owner->blocked_on;
+  }
+}
+
+/**
+ * Remove the specified mutex from the held mutexes of the specified task, if it is there
+ */
+static void rtosMutexUnlinkHeld(rtosMutexHandle_t mutex, rtosTaskHandle_t task) {
+  rtosMutexHandle_t* link = &task->held_mutexes;
+  while (*link != NULL && *link != mutex) {
+    link = &(*link)->held_next;
+  }
+  if (*link == mutex) {
+    *link            = mutex->held_next;
+    mutex->held_next = NULL;
+  }
+}
+
+/**
+ * Check whether the specified mutex is plain: it has no priority protocol and is not robust
+ *
+ * A plain mutex never changes its owner's priority, so it is not linked into its owner's held mutexes, and an
+ * uncontended acquire or release only has to claim or clear the owner. Mutexes with priority inheritance or a ceiling
+ * change priorities on acquire and release, and robust mutexes must be found when their owner is deleted, so they
+ * always take the slow path.
+ */
+static bool rtosMutexIsPlain(rtosMutexHandle_t mutex) {
+  return (mutex->attr_bits & (RTOS_MUTEX_PRIO_INHERIT | RTOS_MUTEX_PRIO_CEILING | RTOS_MUTEX_ROBUST)) == 0;
+}
+
+/**
+ * Try to claim the specified plain mutex for the running task with a single exclusive store, without masking interrupts
+ *
+ * Any exception between the load and the store clears the exclusive monitor, so the store fails and is retried if
+ * another task could have run in between.
+ *
+ * @returns true if the mutex was available and is now owned by the running task
+ */
+static bool rtosMutexTryClaim(rtosMutexHandle_t mutex) {
+  volatile uint32_t* owner = (volatile uint32_t*) &mutex->acquired;
+  do {
+    if (__LDREXW(owner) != 0) {
+      __CLREX();
+      return false;
+    }
+  } while (__STREXW((uint32_t) rtos_running_task, owner) != 0);
+  return true;
+}
+
+/**
+ * Try to release the specified plain mutex held by the running task with a single exclusive store
+ *
+ * A task can only start waiting on the mutex after a context switch, which clears the exclusive monitor, so no waiter
+ * can be missed between the check and the store.
+ *
+ * @returns true if no tasks were blocked on the mutex and it is now available
+ */
+static bool rtosMutexTryUnclaim(rtosMutexHandle_t mutex) {
+  volatile uint32_t* owner = (volatile uint32_t*) &mutex->acquired;
+  do {
+    if (__LDREXW(owner) != (uint32_t) rtos_running_task || mutex->blocked.list.head != NULL) {
+      __CLREX();
+      return false;
+    }
+  } while (__STREXW(0, owner) != 0);
+  return true;
+}
+
+/**
+ * Give ownership of the specified available mutex to the specified task
+ *
+ * Adds the mutex to the task's held mutexes, unless it is plain. A ceiling mutex raises the task to the ceiling
+ * immediately. If other tasks are still blocked on an inheritance mutex, the task inherits their priority.
+ */
+static void rtosMutexTake(rtosMutexHandle_t mutex, rtosTaskHandle_t task) {
+  mutex->acquired = task;
+  if (!rtosMutexIsPlain(mutex)) {
+    mutex->held_next   = task->held_mutexes;
+    task->held_mutexes = mutex;
+  }
+
+  if (mutex->ceiling > task->priority) {
+    rtosChangeTaskPriority(task, mutex->ceiling);
+  }
+
+  if (mutex->attr_bits & RTOS_MUTEX_PRIO_INHERIT) {
+    rtosPriority_t waiter_priority = rtosWaitQueueHighestPriority(&mutex->blocked);
+    if (waiter_priority > task->priority) {
+      rtosChangeTaskPriority(task, waiter_priority);
+    }
+  }
+}
+
+/**
+ * Block the running task on the specified unavailable mutex until it is woken
+ *
+ * If priority inheritance is enabled, the chain of owners is boosted while the task waits, and recomputed once the
+ * task stops waiting, whether or not it was woken by a release.
+ *
+ * @return The reason the task was woken: RTOS_OK if a release handed it the mutex, RTOS_ERROR_OWNER_DIED if the
+ *         deletion of its owner did, RTOS_ERROR_TIMEOUT, or RTOS_ERROR if the mutex was deleted or the task was
+ *         suspended
+ */
+static rtosStatus_t rtosMutexBlock(rtosMutexHandle_t mutex, rtosTaskState_t state) {
+  rtos_running_task->state      = state;
+  rtos_running_task->blocked_on = mutex;
+  rtosWaitQueueInsert(&mutex->blocked, rtos_running_task);
+  rtosMutexBoostOwners(mutex, rtos_running_task->priority);
+
+  rtosExitCritical();
+  rtosInvokeScheduler();
+  rtosEnterCritical();
+
+  rtos_running_task->blocked_on = NULL;
+  rtosMutexUpdateOwners(mutex);
+  return rtos_running_task->wake_status;
+}
+
 /**
  * Create a new mutex
  *
- * @param attrs     Any additional mutex attributes
+ * With RTOS_MUTEX_PRIO_CEILING, the mutex uses the immediate priority-ceiling protocol. The owner is raised to the
+ * ceiling priority as soon as it acquires the mutex. The ceiling must be at least the priority of any task that uses
+ * it.
+ *
+ * With RTOS_MUTEX_ROBUST, the mutex is released if its owner is deleted, and the next task to acquire it is told so by
+ * RTOS_ERROR_OWNER_DIED, as the data it protects may be inconsistent. Otherwise, the mutex is abandoned.
+ *
+ * With RTOS_MUTEX_PRIO_ORDER, blocked tasks acquire the mutex in order of priority rather than in FIFO order.
+ *
+ * @param attrs     Any additional mutex attributes, or NULL for the defaults
  * @param mutex     The mutex object to initialize
  *
  * @return  - RTOS_OK               on success
- *          - RTOS_ERROR_PARAMETER  if the mutex is NULL or invalid
+ *          - RTOS_ERROR_PARAMETER  if the mutex is NULL or invalid, or the ceiling priority is invalid
  */
 rtosStatus_t rtosMutexNew(const rtosMutexAttr_t* attrs, rtosMutexHandle_t mutex) {
 
@@ -29,13 +208,27 @@ rtosStatus_t rtosMutexNew(const rtosMutexAttr_t* attrs, rtosMutexHandle_t mutex)
     return RTOS_ERROR_PARAMETER;
   }
 
+  // With no attributes, the mutex is a plain mutex
+  static const rtosMutexAttr_t default_attrs = {NULL, 0, RTOS_PRIORITY_NONE};
+  if (attrs == NULL) {
+    attrs = &default_attrs;
+  }
+
+  // A ceiling mutex needs a valid ceiling, and cannot also use priority inheritance
+  if ((attrs->attr_bits & RTOS_MUTEX_PRIO_CEILING)
+      && (attrs->ceiling_priority == RTOS_PRIORITY_NONE || attrs->ceiling_priority > RTOS_PRIORITY_REALTIME
+          || (attrs->attr_bits & RTOS_MUTEX_PRIO_INHERIT))) {
+    return RTOS_ERROR_PARAMETER;
+  }
+
   // Initialize the mutex struct fields
-  mutex->name          = attrs->name;
-  mutex->attr_bits     = attrs->attr_bits;
-  mutex->count         = 1;
-  mutex->acquired      = NULL;
-  mutex->blocked       = NULL;
-  mutex->init_priority = RTOS_PRIORITY_NONE;
+  mutex->name      = attrs->name;
+  mutex->attr_bits = attrs->attr_bits;
+  mutex->acquired   = NULL;
+  mutex->owner_died = false;
+  mutex->ceiling   = (attrs->attr_bits & RTOS_MUTEX_PRIO_CEILING) ? attrs->ceiling_priority : RTOS_PRIORITY_NONE;
+  mutex->held_next = NULL;
+  rtosWaitQueueInit(&mutex->blocked, attrs->attr_bits & RTOS_MUTEX_PRIO_ORDER);
 
   // Add the mutex to the global list of mutex
   mutex->next  = rtos_mutexes;
@@ -47,6 +240,8 @@ rtosStatus_t rtosMutexNew(const rtosMutexAttr_t* attrs, rtosMutexHandle_t mutex)
 /**
  * Delete the specified mutex object
  *
+ * If the mutex is held, the owner gives it up without releasing it, and loses any priority it took from the mutex.
+ *
  * @return  - RTOS_OK               on success
  *          - RTOS_ERROR_PARAMETER  if the mutex is NULL or invalid
  */
@@ -57,6 +252,8 @@ rtosStatus_t rtosMutexDelete(const rtosMutexHandle_t mutex) {
     return RTOS_ERROR_PARAMETER;
   }
 
+  rtosEnterCritical();
+
   // Remove the mutex from the global list of mutexes
   rtosMutexHandle_t prev_mutex = NULL;
   rtosMutexHandle_t cur_mutex  = rtos_mutexes;
@@ -69,17 +266,24 @@ rtosStatus_t rtosMutexDelete(const rtosMutexHandle_t mutex) {
       }
       break;
     }
-    cur_mutex = cur_mutex->next;
+    prev_mutex = cur_mutex;
+    cur_mutex  = cur_mutex->next;
   }
 
   // Unblock all blocked tasks
-  // NOTE: Tasks unblocked via mutex deletion return a unique error since the mutex never became available
-  __disable_irq();
-  while (mutex->blocked != NULL) {
-    rtosTaskHandle_t unblocked = rtosPopTaskListHead(&mutex->blocked);
-    rtosInsertTaskListTail(rtosGetReadyTaskQueue(unblocked->priority), unblocked);
+  // NOTE: Tasks unblocked via mutex deletion return RTOS_ERROR since the mutex never became available
+  while (mutex->blocked.list.head != NULL) {
+    rtosUnblockTask(mutex->blocked.list.head, RTOS_ERROR);
   }
-  __enable_irq();
+
+  // Remove the mutex from its owner's held mutexes, so the owner no longer takes its ceiling or inherits through it
+  rtosTaskHandle_t owner = mutex->acquired;
+  mutex->acquired        = NULL;
+  if (owner != NULL && owner != &rtos_mutex_abandoned) {
+    rtosMutexUnlinkHeld(mutex, owner);
+    rtosMutexUpdatePriority(owner);
+  }
+  rtosExitCritical();
 
   rtosInvokeScheduler();
 
@@ -90,9 +294,12 @@ rtosStatus_t rtosMutexDelete(const rtosMutexHandle_t mutex) {
  * Attempt to acquire the specified mutex
  *
  * @return  - RTOS_OK               on success
- *          - RTOS_ERROR            if the mutex was deleted while trying to acquire it
+ *          - RTOS_ERROR_OWNER_DIED on success, if the mutex is robust and its previous owner was deleted while holding
+ *                                  it. The task owns the mutex, but should check the data it protects
+ *          - RTOS_ERROR            if the mutex was deleted, or the task was suspended, while trying to acquire it, or
+ *                                  the mutex was abandoned by its owner
  *          - RTOS_ERROR_TIMEOUT    if the mutex could not be acquired in the specified timeout
- *          - RTOS_ERROR_PARAMETER  if the mutex is NULL or invalid
+ *          - RTOS_ERROR_PARAMETER  if the mutex is NULL or invalid, or the task's priority is above the mutex ceiling
  *          - RTOS_ERROR_RESOURCE   if the mutex could not be acquired and no timeout was specified
  */
 rtosStatus_t rtosMutexAcquire(const rtosMutexHandle_t mutex, uint32_t timeout) {
@@ -102,78 +309,50 @@ rtosStatus_t rtosMutexAcquire(const rtosMutexHandle_t mutex, uint32_t timeout) {
     return RTOS_ERROR_PARAMETER;
   }
 
-  // Disable interrupts to ensure count is read and written atomically
-  __disable_irq();
-
-  // Timeout value is set to zero so try once and then exit
-  if (timeout == 0) {
-    if (mutex->count == 0) {
-      __enable_irq();
-      return RTOS_ERROR_RESOURCE;
-    }
-
-    mutex->count         = 0;
-    mutex->acquired      = rtos_running_task;
-    mutex->init_priority = rtos_running_task->priority;
-    __enable_irq();
-    return RTOS_OK;
+  // A task may not use a ceiling mutex whose ceiling is below its own priority
+  if (mutex->ceiling != RTOS_PRIORITY_NONE && rtos_running_task->base_priority > mutex->ceiling) {
+    return RTOS_ERROR_PARAMETER;
   }
 
-  // Timeout value is set to forever so block until the mutex is available
-  else if (timeout == RTOS_WAIT_FOREVER) {
-
-    // If the mutex is unavailable, block the current task
-    while (mutex->count == 0) {
-      rtos_running_task->state = RTOS_TASK_BLOCKED;
-      rtosInsertTaskListTail(&mutex->blocked, rtos_running_task);
-
-      // If priority inheritance is enabled, promote the priority of the task that acquired the mutex
-      if ((mutex->attr_bits & RTOS_MUTEX_PRIO_INHERIT) && rtos_running_task->priority > mutex->acquired->priority) {
-        mutex->acquired->priority = rtos_running_task->priority;
-        rtosInsertTaskListTail(rtosGetReadyTaskQueue(mutex->acquired->priority), mutex->acquired);
-      }
-
-      __enable_irq();
-      rtosInvokeScheduler();
-      __disable_irq();
-    }
-
-    // Once the mutex is available, acquire it
-    mutex->count         = 0;
-    mutex->acquired      = rtos_running_task;
-    mutex->init_priority = rtos_running_task->priority;
-    __enable_irq();
+  // If a plain mutex is uncontended, acquire it without entering the kernel
+  if (rtosMutexIsPlain(mutex) && rtosMutexTryClaim(mutex)) {
     return RTOS_OK;
-
   }
 
-  // Timeout value is a given number of ticks, block until the mutex is available or the timeout expires
-  else {
+  // Enter a critical section to ensure the owner is read and written atomically
+  rtosEnterCritical();
 
-    // If the mutex is unavailable, block the current task
-    while (mutex->count == 0) {
-      rtos_running_task->state           = RTOS_TASK_BLOCKED_TIMEOUT;
-      rtos_running_task->wake_time_ticks = rtosGetSysTickCount() + timeout;
-      rtosInsertTaskListTail(&mutex->blocked, rtos_running_task);
+  // An abandoned mutex can never become available
+  if (mutex->acquired == &rtos_mutex_abandoned) {
+    rtosExitCritical();
+    return RTOS_ERROR;
+  }
 
-      // If priority inheritance is enabled, promote the priority of the task that acquired the mutex
-      if ((mutex->attr_bits & RTOS_MUTEX_PRIO_INHERIT) && rtos_running_task->priority > mutex->acquired->priority) {
-        mutex->acquired->priority = rtos_running_task->priority;
-        rtosInsertTaskListTail(rtosGetReadyTaskQueue(mutex->acquired->priority), mutex->acquired);
-      }
+  // If the mutex is available, acquire it, reporting once that its previous owner died holding it
+  if (mutex->acquired == NULL) {
+    const rtosStatus_t status = mutex->owner_died ? RTOS_ERROR_OWNER_DIED : RTOS_OK;
+    mutex->owner_died         = false;
+    rtosMutexTake(mutex, rtos_running_task);
+    rtosExitCritical();
+    return status;
+  }
 
-      __enable_irq();
-      rtosInvokeScheduler();
-      __disable_irq();
-    }
+  // Timeout value is set to zero so don't wait
+  if (timeout == 0) {
+    rtosExitCritical();
+    return RTOS_ERROR_RESOURCE;
+  }
 
-    // Once the mutex is available, acquire it
-    mutex->count         = 0;
-    mutex->acquired      = rtos_running_task;
-    mutex->init_priority = rtos_running_task->priority;
-    __enable_irq();
-    return RTOS_OK;
+  // Otherwise, block the current task until a release hands it the mutex, the timeout expires, or the mutex is deleted
+  rtosTaskState_t state = RTOS_TASK_BLOCKED;
+  if (timeout != RTOS_WAIT_FOREVER) {
+    state = RTOS_TASK_BLOCKED_TIMEOUT;
+    rtosTimeoutInsert(rtos_running_task, rtos_ticks + timeout);
   }
+  rtosStatus_t status = rtosMutexBlock(mutex, state);
+
+  rtosExitCritical();
+  return status;
 }
 
 /**
@@ -190,34 +369,114 @@ rtosStatus_t rtosMutexRelease(const rtosMutexHandle_t mutex) {
     return RTOS_ERROR_PARAMETER;
   }
 
-  // Disable interrupts
-  __disable_irq();
+  // If no tasks are blocked on a plain mutex, release it without entering the kernel
+  if (rtosMutexIsPlain(mutex) && rtosMutexTryUnclaim(mutex)) {
+    return RTOS_OK;
+  }
+
+  // Enter a critical section
+  rtosEnterCritical();
 
   // Ensure the mutex is acquired and that the releasing thread
-  if (mutex->count == 1 || rtos_running_task != mutex->acquired) {
-    __enable_irq();
+  if (mutex->acquired == NULL || rtos_running_task != mutex->acquired) {
+    rtosExitCritical();
     return RTOS_ERROR_RESOURCE;
   }
 
-  // Release the mutex
-  mutex->count = 1;
-
-  // If there are blocked tasks, unblock the first task
-  if (mutex->blocked != NULL) {
-    rtosTaskHandle_t unblocked = rtosPopTaskListHead(&mutex->blocked);
-    unblocked->state           = RTOS_TASK_READY;
-    rtosInsertTaskListTail(rtosGetReadyTaskQueue(unblocked->priority), unblocked);
+  // Remove the mutex from the releasing task's held mutexes
+  rtosMutexUnlinkHeld(mutex, rtos_running_task);
+
+  // Drop any priority inherited through this mutex. Priority inherited through other held mutexes is kept
+  const rtosPriority_t prev_priority = rtos_running_task->priority;
+  rtosChangeTaskPriority(rtos_running_task, rtosMutexEffectivePriority(rtos_running_task));
+
+  // If there are blocked tasks, hand ownership directly to the first task in the queue, so no other task can take the
+  // mutex before it runs. Otherwise, release the mutex
+  rtosTaskHandle_t next_owner = mutex->blocked.list.head;
+  if (next_owner != NULL) {
+    rtosUnblockTask(next_owner, RTOS_OK);
+    rtosMutexTake(mutex, next_owner);
+  } else {
+    mutex->acquired = NULL;
+  }
 
-    // If priority inheritance is enabled, ensure the priority is demoted back to its original value
-    if ((mutex->attr_bits & RTOS_MUTEX_PRIO_INHERIT) && rtos_running_task->priority != mutex->init_priority) {
-      rtos_running_task->priority = mutex->init_priority;
-    }
+  // Either a woken task or the priority drop may mean this task should be preempted
+  const bool reschedule = (next_owner != NULL || rtos_running_task->priority != prev_priority);
+  rtosExitCritical();
 
-    __enable_irq();
+  if (reschedule) {
     rtosInvokeScheduler();
-    __disable_irq();
   }
-
-  __enable_irq();
   return RTOS_OK;
 }
+
+/**
+ * Recompute the effective priority of the specified task after its base priority changed
+ *
+ * If the task is waiting on a mutex, the change is propagated along the chain of owners. Must be called from within a
+ * critical section. The caller is responsible for invoking the scheduler.
+ */
+void rtosMutexUpdatePriority(rtosTaskHandle_t task) {
+  rtosChangeTaskPriority(task, rtosMutexEffectivePriority(task));
+  rtosMutexUpdateOwners(task->blocked_on);
+}
+
+/**
+ * Stop the specified task waiting on a mutex, if it is, so that the owner of the mutex no longer inherits its priority
+ *
+ * The task must already have been removed from the mutex's wait queue. Must be called from within a critical section.
+ */
+void rtosMutexCancelWait(rtosTaskHandle_t task) {
+  if (task->blocked_on != NULL) {
+    rtosMutexUpdateOwners(task->blocked_on);
+    task->blocked_on = NULL;
+  }
+}
+
+/**
+ * Abandon the specified mutex, whose owner is being deleted, and wake the tasks blocked on it with RTOS_ERROR
+ */
+static void rtosMutexAbandon(rtosMutexHandle_t mutex) {
+  mutex->acquired = &rtos_mutex_abandoned;
+  while (mutex->blocked.list.head != NULL) {
+    rtosUnblockTask(mutex->blocked.list.head, RTOS_ERROR);
+  }
+}
+
+/**
+ * Give up every mutex held by the specified task, which is being deleted
+ *
+ * A robust mutex is released, and handed to the first task blocked on it, if any. Its next owner gets
+ * RTOS_ERROR_OWNER_DIED from rtosMutexAcquire(). Any other mutex is abandoned: it stays locked, the tasks blocked on
+ * it are woken with RTOS_ERROR, and later attempts to acquire it fail. Plain mutexes are not in the task's held
+ * mutexes, so they are found in the global list of mutexes. The task also stops waiting on any mutex, as by
+ * rtosMutexCancelWait(). Must be called from within a critical section.
+ */
+void rtosMutexReleaseAll(rtosTaskHandle_t task) {
+  rtosMutexCancelWait(task);
+
+  while (task->held_mutexes != NULL) {
+    rtosMutexHandle_t mutex = task->held_mutexes;
+    task->held_mutexes      = mutex->held_next;
+    mutex->held_next        = NULL;
+
+    if (mutex->attr_bits & RTOS_MUTEX_ROBUST) {
+      rtosTaskHandle_t next_owner = mutex->blocked.list.head;
+      if (next_owner != NULL) {
+        rtosUnblockTask(next_owner, RTOS_ERROR_OWNER_DIED);
+        rtosMutexTake(mutex, next_owner);
+      } else {
+        mutex->acquired   = NULL;
+        mutex->owner_died = true;
+      }
+    } else {
+      rtosMutexAbandon(mutex);
+    }
+  }
+
+  for (rtosMutexHandle_t mutex = rtos_mutexes; mutex != NULL; mutex = mutex->next) {
+    if (mutex->acquired == task) {
+      rtosMutexAbandon(mutex);
+    }
+  }
+}
@@ -6,30 +6,36 @@
 #ifndef __RTOS_MUTEX_H
 #define __RTOS_MUTEX_H
 
+#include <stdbool.h>
 #include <stdint.h>
 
 #include "status.h"
 #include "task.h"
+#include "waitqueue.h"
 
 // Define mutex attribute options
 #define RTOS_MUTEX_PRIO_INHERIT 0x00000002U
+#define RTOS_MUTEX_PRIO_CEILING 0x00000004U
 #define RTOS_MUTEX_ROBUST 0x00000008U
+#define RTOS_MUTEX_PRIO_ORDER 0x00000010U
 
 /// Mutex attributes
 typedef struct {
-  const char* name;
-  uint32_t    attr_bits;
+  const char*    name;
+  uint32_t       attr_bits;
+  rtosPriority_t ceiling_priority;  ///< The ceiling priority, if RTOS_MUTEX_PRIO_CEILING is set
 } rtosMutexAttr_t;
 
 /// Mutex
 typedef struct rtosMutex_tag {
-  const char*           name;           ///< The name of the mutex
-  uint32_t              count;          ///< The current mutex value
-  uint32_t              attr_bits;      ///< Attribute bits. Default=0
-  rtosTaskHandle_t      blocked;        ///< The list of tasks blocked by the mutex
-  rtosTaskHandle_t      acquired;       ///< The task that acquired the mutex
-  rtosPriority_t        init_priority;  ///< The priority of acquired
-  struct rtosMutex_tag* next;           ///< The next mutex in the global list
+  const char*           name;       ///< The name of the mutex
+  uint32_t              attr_bits;  ///< Attribute bits. Default=0
+  rtosWaitQueue_t       blocked;    ///< The tasks blocked by the mutex
+  rtosPriority_t        ceiling;    ///< The ceiling priority, or RTOS_PRIORITY_NONE if not a ceiling mutex
+  rtosTaskHandle_t      acquired;   ///< The task that acquired the mutex, or NULL if the mutex is available
+  bool                  owner_died; ///< Whether a robust mutex was released by its owner's deletion and not yet retaken
+  struct rtosMutex_tag* held_next;  ///< The next mutex held by the same task. Plain mutexes are not linked
+  struct rtosMutex_tag* next;       ///< The next mutex in the global list
 } rtosMutex_t;
 
 typedef rtosMutex_t* rtosMutexHandle_t;
@@ -39,4 +45,9 @@ rtosStatus_t rtosMutexDelete(rtosMutexHandle_t mutex);
 rtosStatus_t rtosMutexAcquire(rtosMutexHandle_t mutex, uint32_t timeout);
 rtosStatus_t rtosMutexRelease(rtosMutexHandle_t mutex);
 
+rtosPriority_t rtosMutexEffectivePriority(rtosTaskHandle_t task);
+void           rtosMutexUpdatePriority(rtosTaskHandle_t task);
+void           rtosMutexCancelWait(rtosTaskHandle_t task);
+void           rtosMutexReleaseAll(rtosTaskHandle_t task);
+
 #endif  // __RTOS_MUTEX_H
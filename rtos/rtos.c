@@ -9,51 +9,102 @@
 
 #include <LPC17xx.h>
 
-#include "context.h"
 #include "rtos.h"
 
-uint32_t rtos_ticks   = 0;
-uint32_t systick_freq = 1000;  // Default systick frequency = 1000Hz (1ms)
+rtosTicks_t      rtos_ticks     = 0;
+uint32_t         systick_freq   = 1000;  // Default systick frequency = 1000Hz (1ms)
+rtosTaskHandle_t rtos_idle_task = NULL;
 
 /**
  * SysTick ISR
  *
- * Increment the rtos_tick count, and invoke the scheduler.
+ * Increment the rtos_tick count, expire any timeouts, charge the tick to the running task and invoke the scheduler.
  */
 void SysTick_Handler(void) {
-  popR4();
 
   // Increment tick count
   rtos_ticks++;
 
   // If the RTOS & its scheduler are running, run invoke the scheduler
   if (rtos_running_task != NULL) {
-    rtosInvokeScheduler();
+    rtosTimeoutTick();
+    rtosSchedulerTick();
   }
-
-  pushR4();
 }
 
 /**
- * SVC (Supervisor Call) ISR
+ * Sleep with the SysTick suppressed until the next timeout expires or another interrupt occurs
  *
- * Used to start the first task.
- */
-void SVC_Handler(void) {
-  popR4();
-  rtosRestoreContext(rtos_running_task->stack_pointer);
-  pushR4();
-}
-
-/**
- * PendSV ISR
+ * The SysTick is reprogrammed to fire once at the tick on which the earliest timeout in the timeout list expires,
+ * rather than every tick. On wake, rtos_ticks is advanced by the number of whole ticks that were skipped. The tick on
+ * which the sleep ends is still delivered by the SysTick ISR as usual.
  *
- * Used to perform a context switch.
+ * Only sleeps if no other task is ready, since ready tasks of the idle priority rely on the tick for round-robin.
  */
-void PendSV_Handler(void) {
-  popR4();
-  rtosPerformContextSwitch();
-  pushR4();
+static void rtosTicklessSleep(void) {
+  const uint32_t cycles_per_tick = SystemCoreClock / systick_freq;
+
+  // Use PRIMASK rather than a kernel critical section: WFI only wakes for interrupts that are not masked by BASEPRI,
+  // but does wake for interrupts masked by PRIMASK
+  __disable_irq();
+
+  // Determine how many ticks may be skipped, limited by the width of the SysTick counter
+  uint32_t idle_ticks = rtosTimeoutNextExpiry();
+  if (idle_ticks > SysTick_LOAD_RELOAD_Msk / cycles_per_tick) {
+    idle_ticks = SysTick_LOAD_RELOAD_Msk / cycles_per_tick;
+  }
+
+  // Fall back to sleeping until the next tick if there is nothing to skip, or if a tick is already pending
+  if (rtos_ready_priorities != 0 || idle_ticks < 2 || (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk)) {
+    __enable_irq();
+    __WFE();
+    return;
+  }
+
+  // Stretch the current tick period to end on the tick at which the earliest timeout expires
+  SysTick->CTRL &= ~SysTick_CTRL_ENABLE_Msk;
+  const uint32_t reload = SysTick->VAL + cycles_per_tick * (idle_ticks - 1);
+  SysTick->LOAD         = reload;
+  SysTick->VAL          = 0;
+  SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+
+  // Sleep until any interrupt becomes pending. Interrupts are masked, so the ISR only runs once they are re-enabled
+  __DSB();
+  __WFI();
+  __ISB();
+
+  // Stop the SysTick. Reading CTRL clears COUNTFLAG, so read it once
+  const uint32_t ctrl = SysTick->CTRL;
+  SysTick->CTRL       = ctrl & ~SysTick_CTRL_ENABLE_Msk;
+
+  uint32_t skipped_ticks;
+  uint32_t next_tick_cycles;
+  if (ctrl & SysTick_CTRL_COUNTFLAG_Msk) {
+
+    // Slept the whole period. The pending SysTick ISR accounts for the final tick
+    skipped_ticks    = idle_ticks - 1;
+    next_tick_cycles = cycles_per_tick;
+  } else {
+
+    // Woken early by another interrupt. Count the whole ticks that elapsed and resume partway through the current one
+    const uint32_t remaining = SysTick->VAL;
+    skipped_ticks            = (idle_ticks - 1) - remaining / cycles_per_tick;
+    next_tick_cycles         = remaining % cycles_per_tick;
+    if (next_tick_cycles == 0) {
+      next_tick_cycles = cycles_per_tick;
+    }
+  }
+
+  // Account for the skipped ticks
+  rtos_ticks += skipped_ticks;
+
+  // Restart the SysTick at the next tick boundary, then restore the regular tick period once it reloads
+  SysTick->LOAD = next_tick_cycles - 1;
+  SysTick->VAL  = 0;
+  SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+  SysTick->LOAD = cycles_per_tick - 1;
+
+  __enable_irq();
 }
 
 /**
@@ -63,15 +114,38 @@ void PendSV_Handler(void) {
  */
 void rtosIdleTask(void* arg) {
   while (true) {
+#if RTOS_TICKLESS_IDLE
+    rtosTicklessSleep();
+#else
     __WFE();
+#endif
   }
 }
 
 /**
- * Get the current system tick count
+ * Get the low 32 bits of the current system tick count
  */
 uint32_t rtosGetSysTickCount(void) {
-  return rtos_ticks;
+  return (uint32_t) rtos_ticks;
+}
+
+/**
+ * Get the full 64-bit system tick count
+ *
+ * The two halves cannot be read in a single access, so the high half is read again to detect a carry from the low half
+ * between the reads. This is safe to call from tasks and ISRs without masking interrupts.
+ */
+rtosTicks_t rtosGetSysTickCount64(void) {
+  volatile uint32_t* ticks_words = (volatile uint32_t*) &rtos_ticks;  // Little-endian: [0] = low, [1] = high
+  uint32_t           high;
+  uint32_t           low;
+
+  do {
+    high = ticks_words[1];
+    low  = ticks_words[0];
+  } while (high != ticks_words[1]);
+
+  return ((rtosTicks_t) high << 32) | low;
 }
 
 /**
@@ -97,11 +171,16 @@ void rtosInitialize(void) {
   // Ensure the systick frequency is set
   rtosSetSysTickFreq(systick_freq);
 
+  // Run SysTick and PendSV at the least urgent priority, so that they never preempt an ISR or each other, and are
+  // masked by kernel critical sections
+  NVIC_SetPriority(SysTick_IRQn, RTOS_KERNEL_INTERRUPT_PRIORITY);
+  NVIC_SetPriority(PendSV_IRQn, RTOS_KERNEL_INTERRUPT_PRIORITY);
+
   // Initialize all the task control blocks
   rtosTaskInitAll();
 
   // Create the idle task
-  rtosTaskNew(rtosIdleTask, NULL, RTOS_PRIORITY_IDLE, NULL);
+  rtosTaskNewStack(rtosIdleTask, NULL, RTOS_PRIORITY_IDLE, IDLE_TASK_STACK_SIZE, NULL, &rtos_idle_task);
 }
 
 /**
@@ -110,12 +189,15 @@ void rtosInitialize(void) {
 void rtosBegin(void) {
 
   // Prepare the first task
-  rtos_running_task = rtosGetReadyTask(rtosGetHighestReadyPriority());
-  if (rtos_running_task == NULL) {
+  rtosPriority_t priority = rtosGetHighestReadyPriority();
+  if (priority == RTOS_PRIORITY_NONE) {
     return;
   }
-  rtosPopTaskListHead(rtosGetReadyTaskQueue(rtos_running_task->priority));
+  rtos_running_task        = rtosPopReadyTask(priority);
   rtos_running_task->state = RTOS_TASK_RUNNING;
+#if RTOS_MPU_STACK_GUARD
+  rtosStackGuardInit(rtos_running_task);
+#endif
 
   // Set the PSP to the MSP
   // This is temporary (PSP will be overwritten once the task starts) and useless (The stack is not used between
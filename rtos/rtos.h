@@ -8,15 +8,28 @@
 
 #include <stdint.h>
 
+#include "critical.h"
 #include "globals.h"
+#include "isr.h"
+#include "mempool.h"
 #include "mutex.h"
 #include "scheduler.h"
+#include "sections.h"
 #include "semaphore.h"
+#include "stack.h"
 #include "task.h"
+#include "timeout.h"
+#include "waitqueue.h"
 
-uint32_t rtosGetSysTickCount(void);
-uint32_t rtosGetSysTickFreq(void);
-void     rtosSetSysTickFreq(uint32_t freq);
+/// If nonzero, the idle task suppresses the SysTick until the next timeout expires rather than waking every tick
+#ifndef RTOS_TICKLESS_IDLE
+#define RTOS_TICKLESS_IDLE 1
+#endif
+
+uint32_t    rtosGetSysTickCount(void);
+rtosTicks_t rtosGetSysTickCount64(void);
+uint32_t    rtosGetSysTickFreq(void);
+void        rtosSetSysTickFreq(uint32_t freq);
 
 void rtosInitialize(void);
 void rtosBegin(void);
@@ -6,29 +6,35 @@
 
 #include <stdlib.h>
 
-#include "context.h"
 #include "globals.h"
+#include "rtos.h"
 #include "scheduler.h"
+#include "timeout.h"
+#include "waitqueue.h"
 
-rtosTaskHandle_t rtos_inactive_tasks                   = NULL;
-rtosTaskHandle_t rtos_ready_tasks[RTOS_PRIORITY_COUNT] = {NULL};
+rtosTaskList_t   rtos_inactive_tasks                   = {NULL, NULL};
+rtosTaskList_t   rtos_ready_tasks[RTOS_PRIORITY_COUNT] = {{NULL, NULL}};
 rtosTaskHandle_t rtos_running_task                     = NULL;
-rtosTaskHandle_t rtos_delayed_tasks                    = NULL;  // Stored in order of wake time
-rtosTaskHandle_t rtos_blocked_tasks                    = NULL;
-rtosTaskHandle_t rtos_terminated_tasks                 = NULL;
+uint32_t         rtos_ready_priorities                 = 0;  // Bit (prio - IDLE) set iff that ready queue is nonempty
+bool             rtos_reschedule_pending               = false;
+uint32_t         rtos_timeslices[RTOS_PRIORITY_COUNT]  = {SCHEDULER_TIMESLICE,
+                                                         SCHEDULER_TIMESLICE,
+                                                         SCHEDULER_TIMESLICE,
+                                                         SCHEDULER_TIMESLICE,
+                                                         SCHEDULER_TIMESLICE,
+                                                         SCHEDULER_TIMESLICE,
+                                                         SCHEDULER_TIMESLICE};
 
 /**
  * Get the priority of the highest-priority non-empty queue of ready tasks.
  *
+ * The bit vector of non-empty queues is maintained incrementally by the ready queue insert/pop functions, so this is
+ * a single CLZ rather than a poll of every queue.
+ *
  * @returns The priority of the queue, or RTOS_PRIORITY_NONE of no ready tasks found.
  */
 rtosPriority_t rtosGetHighestReadyPriority(void) {
-
-  // Create a bit vector representing whether each queue is nonempty
-  uint32_t queue_vec = 0;
-  for (unsigned prio = RTOS_PRIORITY_IDLE; prio < RTOS_PRIORITY_COUNT; prio++) {
-    queue_vec |= !!rtos_ready_tasks[prio - RTOS_PRIORITY_IDLE] << (prio - RTOS_PRIORITY_IDLE);
-  }
+  uint32_t queue_vec = rtos_ready_priorities;
 
   // Determine the number of leading zeros in the bit vector
   uint32_t leading_zeros;
@@ -41,7 +47,7 @@ rtosPriority_t rtosGetHighestReadyPriority(void) {
 /**
  * Get the ready task queue with the specified priority
  */
-rtosTaskHandle_t* rtosGetReadyTaskQueue(rtosPriority_t priority) {
+rtosTaskList_t* rtosGetReadyTaskQueue(rtosPriority_t priority) {
   if (priority == RTOS_PRIORITY_NONE) {
     return NULL;
   }
@@ -53,153 +59,344 @@ rtosTaskHandle_t* rtosGetReadyTaskQueue(rtosPriority_t priority) {
  * Get the ready task with the specified priority
  */
 rtosTaskHandle_t rtosGetReadyTask(rtosPriority_t priority) {
-  rtosTaskHandle_t* queue = rtosGetReadyTaskQueue(priority);
-  return (queue == NULL) ? NULL : *queue;
+  rtosTaskList_t* queue = rtosGetReadyTaskQueue(priority);
+  return (queue == NULL) ? NULL : queue->head;
 };
 
+/**
+ * Check whether task a has an earlier absolute deadline than task b
+ *
+ * Tasks without a deadline are treated as having a later deadline than any task with one.
+ */
+bool rtosDeadlineBefore(rtosTaskHandle_t a, rtosTaskHandle_t b) {
+  if (a->deadline_ticks == 0) {
+    return false;
+  }
+  if (b->deadline_ticks == 0) {
+    return true;
+  }
+  return a->abs_deadline_ticks < b->abs_deadline_ticks;
+}
+
+/**
+ * Insert the specified task into the specified queue in order of absolute deadline
+ *
+ * @param before_equal  If true, insert the task ahead of tasks with an equal deadline. Otherwise, insert it after them
+ */
+static void rtosInsertDeadlineOrdered(rtosTaskList_t* queue, rtosTaskHandle_t task, bool before_equal) {
+
+  // Tasks without a deadline are always ordered last
+  if (task->deadline_ticks == 0 && !before_equal) {
+    rtosInsertTaskListTail(queue, task);
+    return;
+  }
+
+  rtosTaskHandle_t cur = queue->head;
+  while (cur != NULL && (before_equal ? rtosDeadlineBefore(cur, task) : !rtosDeadlineBefore(task, cur))) {
+    cur = cur->next;
+  }
+  rtosInsertTaskListBefore(queue, cur, task);
+}
+
+/**
+ * Insert the specified task to the head of the ready queue matching its priority
+ *
+ * The EDF ready queue is kept in order of deadline, so the task is inserted ahead of any task with the same deadline.
+ * Marks the queue as non-empty in the ready bit vector.
+ */
+void rtosInsertReadyTaskHead(rtosTaskHandle_t task) {
+  if (task->priority == SCHEDULER_EDF_PRIORITY) {
+    rtosInsertDeadlineOrdered(rtosGetReadyTaskQueue(task->priority), task, true);
+  } else {
+    rtosInsertTaskListHead(rtosGetReadyTaskQueue(task->priority), task);
+  }
+  rtos_ready_priorities |= 1U << (task->priority - RTOS_PRIORITY_IDLE);
+}
+
+/**
+ * Insert the specified task to the tail of the ready queue matching its priority
+ *
+ * The EDF ready queue is kept in order of deadline, so the task is inserted after any task with the same deadline.
+ * Marks the queue as non-empty in the ready bit vector.
+ */
+void rtosInsertReadyTaskTail(rtosTaskHandle_t task) {
+  if (task->priority == SCHEDULER_EDF_PRIORITY) {
+    rtosInsertDeadlineOrdered(rtosGetReadyTaskQueue(task->priority), task, false);
+  } else {
+    rtosInsertTaskListTail(rtosGetReadyTaskQueue(task->priority), task);
+  }
+  rtos_ready_priorities |= 1U << (task->priority - RTOS_PRIORITY_IDLE);
+}
+
+/**
+ * Remove and return the head of the ready queue with the specified priority
+ *
+ * Clears the queue's bit in the ready bit vector if the queue becomes empty.
+ */
+rtosTaskHandle_t rtosPopReadyTask(rtosPriority_t priority) {
+  rtosTaskList_t*  queue = rtosGetReadyTaskQueue(priority);
+  rtosTaskHandle_t task  = rtosPopTaskListHead(queue);
+  if (queue->head == NULL) {
+    rtos_ready_priorities &= ~(1U << (priority - RTOS_PRIORITY_IDLE));
+  }
+  return task;
+}
+
+/**
+ * Remove the specified task from its ready queue
+ *
+ * Clears the queue's bit in the ready bit vector if the queue becomes empty.
+ */
+void rtosRemoveReadyTask(rtosTaskHandle_t task) {
+  rtosTaskList_t* queue = task->list;
+  rtosRemoveTaskListItem(task);
+  if (queue->head == NULL) {
+    rtos_ready_priorities &= ~(1U << (task->priority - RTOS_PRIORITY_IDLE));
+  }
+}
+
+/**
+ * Change the effective priority of the specified task
+ *
+ * A ready task is moved to the tail of the ready queue of its new priority. A task blocked in a priority-ordered wait
+ * queue is moved behind the waiting tasks of its new priority. The priority of the running task takes effect the next
+ * time it is scheduled. The caller is responsible for invoking the scheduler.
+ */
+void rtosChangeTaskPriority(rtosTaskHandle_t task, rtosPriority_t priority) {
+  if (task->priority == priority) {
+    return;
+  }
+
+  if (task->state == RTOS_TASK_READY) {
+    rtosRemoveReadyTask(task);
+    task->priority = priority;
+    rtosInsertReadyTaskTail(task);
+  } else if (task->wait_queue != NULL && task->wait_queue->priority_ordered) {
+    rtosWaitQueue_t* queue = task->wait_queue;
+    rtosWaitQueueRemove(task);
+    task->priority = priority;
+    rtosWaitQueueInsert(queue, task);
+  } else {
+    task->priority = priority;
+  }
+}
+
+/**
+ * Make the specified blocked task ready
+ *
+ * Removes the task from the wait queue of any object it was waiting on, cancels any pending timeout, and appends the
+ * task to its ready queue.
+ *
+ * @param task    The task to unblock
+ * @param status  The reason the task was unblocked, returned to the task from its wait:
+ *                  - RTOS_OK             if the object it was waiting on became available
+ *                  - RTOS_ERROR_TIMEOUT  if its timeout expired
+ *                  - RTOS_ERROR          if the object it was waiting on was deleted, or the task was suspended
+ */
+void rtosUnblockTask(rtosTaskHandle_t task, rtosStatus_t status) {
+  rtosWaitQueueRemove(task);
+  rtosTimeoutRemove(task);
+  task->wake_status = status;
+  task->state       = RTOS_TASK_READY;
+  rtosInsertReadyTaskTail(task);
+}
+
+/**
+ * Get the length of a full round-robin timeslice of the specified task, in ticks
+ *
+ * This is the task's own timeslice if one is set, or otherwise the timeslice of the task's current priority.
+ */
+uint32_t rtosGetTimeslice(rtosTaskHandle_t task) {
+  if (task->timeslice_ticks != 0) {
+    return task->timeslice_ticks;
+  }
+  return rtos_timeslices[task->priority - RTOS_PRIORITY_IDLE];
+}
+
+/**
+ * Set the default round-robin timeslice of all tasks with the specified priority
+ *
+ * Tasks that have their own timeslice set are unaffected. The new timeslice applies from each task's next timeslice.
+ *
+ * @param priority  The priority to configure
+ * @param ticks     The timeslice, in ticks
+ *
+ * @return  - RTOS_OK               on success
+ *          - RTOS_ERROR_PARAMETER  if the priority is RTOS_PRIORITY_NONE or the timeslice is 0
+ */
+rtosStatus_t rtosSetPriorityTimeslice(rtosPriority_t priority, uint32_t ticks) {
+  if (priority == RTOS_PRIORITY_NONE || priority > RTOS_PRIORITY_COUNT || ticks == 0) {
+    return RTOS_ERROR_PARAMETER;
+  }
+
+  rtos_timeslices[priority - RTOS_PRIORITY_IDLE] = ticks;
+  return RTOS_OK;
+}
+
+/**
+ * Set the round-robin timeslice of the specified task
+ *
+ * The new timeslice applies from the task's next timeslice.
+ *
+ * @param task  The task to configure
+ * @param ticks The timeslice, in ticks, or 0 to use the default timeslice of the task's priority
+ *
+ * @return  - RTOS_OK               on success
+ *          - RTOS_ERROR_PARAMETER  if the task is NULL
+ */
+rtosStatus_t rtosTaskSetTimeslice(rtosTaskHandle_t task, uint32_t ticks) {
+  if (task == NULL) {
+    return RTOS_ERROR_PARAMETER;
+  }
+
+  task->timeslice_ticks = ticks;
+  return RTOS_OK;
+}
+
+/**
+ * Account for one tick of execution by the running task, and invoke the scheduler
+ *
+ * Called from the SysTick ISR only, so that each tick is charged to the running task's timeslice exactly once.
+ */
+void rtosSchedulerTick(void) {
+  if (rtos_running_task->quantum_ticks > 0) {
+    rtos_running_task->quantum_ticks--;
+  }
+
+  rtosInvokeScheduler();
+}
+
+/**
+ * Lock the scheduler, deferring context switches until the matching rtosSchedulerUnlock()
+ *
+ * While locked, tasks are still made ready (e.g. by semaphore releases or expired timeouts), but the running task is
+ * not preempted. The scheduler runs once when the outermost lock is released. Locks nest.
+ *
+ * The lock is held by the running task. If the task blocks or is deleted while it holds the lock, a context switch
+ * still occurs, and other tasks are scheduled normally until the task resumes and unlocks it.
+ */
+rtosStatus_t rtosSchedulerLock(void) {
+  rtos_running_task->scheduler_lock++;
+  return RTOS_OK;
+}
+
+/**
+ * Unlock the scheduler
+ *
+ * If this releases the outermost lock and a context switch was deferred while locked, the scheduler is invoked.
+ *
+ * @return  - RTOS_OK               on success
+ *          - RTOS_ERROR_RESOURCE   if the scheduler is not locked by the running task
+ */
+rtosStatus_t rtosSchedulerUnlock(void) {
+  if (rtos_running_task->scheduler_lock == 0) {
+    return RTOS_ERROR_RESOURCE;
+  }
+
+  rtos_running_task->scheduler_lock--;
+  if (rtos_running_task->scheduler_lock == 0 && rtos_reschedule_pending) {
+    rtos_reschedule_pending = false;
+    rtosInvokeScheduler();
+  }
+  return RTOS_OK;
+}
+
 /**
  * Invoke the scheduler
  *
  * Perform a context switch to the next ready highest priority task by triggering the PendSV exception if:
  *  - The running task has been blocked/terminated, OR
  *  - A higher-priority task is ready, OR
- *  - An equal-priority task is ready and the timeslice has expired
+ *  - An equal-priority EDF task with an earlier deadline is ready, OR
+ *  - An equal-priority task is ready and the timeslice has expired. EDF tasks with a deadline are not timesliced
+ *
+ * A task preempted by a higher-priority task keeps the remainder of its timeslice and resumes ahead of the other tasks
+ * of its priority. A task whose timeslice expired, or which blocked or yielded, starts a full timeslice next time.
+ *
+ * If the scheduler is locked and the running task can continue, the decision is deferred until it is unlocked.
+ *
+ * The decision and the requeue of the running task are made in a critical section, so that an ISR cannot change the
+ * ready queues between them. Only pending PendSV is left outside it.
  */
 void rtosInvokeScheduler(void) {
-  static uint32_t last_switch_ticks = 0;
-
-  // Unblock any delayed tasks whose delay has expired
-  while (rtos_delayed_tasks != NULL && rtos_delayed_tasks->wake_time_ticks == rtos_ticks) {
-    rtosTaskHandle_t unblocked_task = rtosPopTaskListHead(&rtos_delayed_tasks);
-    rtosInsertTaskListHead(rtosGetReadyTaskQueue(unblocked_task->priority), unblocked_task);
+  if (rtos_running_task == NULL) {
+    return;
   }
 
-  // Iterate through each semaphore
-  rtosSemaphoreHandle_t sem = rtos_semaphores;
-  while (sem != NULL) {
-
-    // Iterate through each task blocked by the current semaphore
-    rtosTaskHandle_t prev_task = NULL;
-    rtosTaskHandle_t cur_task  = sem->blocked;
-    while (cur_task != NULL) {
-
-      // If the task has a timeout set and the timeout expired, remove the task from the semaphore's blocked list
-      if (cur_task->state == RTOS_TASK_BLOCKED_TIMEOUT && cur_task->wake_time_ticks == rtos_ticks) {
-        if (prev_task == NULL) {
-          rtosPopTaskListHead(&sem->blocked);
-        } else {
-          prev_task->next = cur_task->next;
-        }
-
-        // Re-add the task to the ready list
-        cur_task->state = RTOS_TASK_READY;
-        rtosInsertTaskListTail(rtosGetReadyTaskQueue(cur_task->priority), cur_task);
-
-        // Increment the current task
-        rtosTaskHandle_t next_task = cur_task->next;
-        cur_task->next             = NULL;
-        cur_task                   = next_task;
-      }
-
-      // Otherwise, skip this task
-      else {
-        prev_task = cur_task;
-        cur_task  = cur_task->next;
-      }
-    }
+  rtosEnterCritical();
 
-    sem = sem->next;
+  if (rtos_running_task->scheduler_lock != 0 && rtos_running_task->state == RTOS_TASK_RUNNING) {
+    rtos_reschedule_pending = true;
+    rtosExitCritical();
+    return;
   }
 
-  // Iterate through each mutex
-  rtosMutexHandle_t mutex = rtos_mutexes;
-  while (mutex != NULL) {
-
-    // Iterate through each task blocked by the current semaphore
-    rtosTaskHandle_t prev_task = NULL;
-    rtosTaskHandle_t cur_task  = mutex->blocked;
-    while (cur_task != NULL) {
-
-      // If the task has a timeout set and the timeout expired, remove the task from the semaphore's blocked list
-      if (cur_task->state == RTOS_TASK_BLOCKED_TIMEOUT && cur_task->wake_time_ticks == rtos_ticks) {
-        if (prev_task == NULL) {
-          rtosPopTaskListHead(&mutex->blocked);
-        } else {
-          prev_task->next = cur_task->next;
-        }
-
-        // Re-add the task to the ready list
-        cur_task->state = RTOS_TASK_READY;
-        rtosInsertTaskListTail(rtosGetReadyTaskQueue(cur_task->priority), cur_task);
-
-        // Increment the current task
-        rtosTaskHandle_t next_task = cur_task->next;
-        cur_task->next             = NULL;
-        cur_task                   = next_task;
-      }
+  rtosPriority_t highest_ready_priority = rtosGetHighestReadyPriority();
 
-      // Otherwise, skip this task
-      else {
-        prev_task = cur_task;
-        cur_task  = cur_task->next;
-      }
+  // Determine whether an equal-priority task should take over from the running task
+  bool equal_priority_switch = false;
+  if (highest_ready_priority == rtos_running_task->priority) {
+    rtosTaskHandle_t next_task = rtosGetReadyTask(highest_ready_priority);
+    if (highest_ready_priority == SCHEDULER_EDF_PRIORITY
+        && (rtos_running_task->deadline_ticks != 0 || next_task->deadline_ticks != 0)) {
+      equal_priority_switch = rtosDeadlineBefore(next_task, rtos_running_task);
+    } else {
+      equal_priority_switch = rtos_running_task->quantum_ticks == 0;
     }
-
-    mutex = mutex->next;
   }
 
-  rtosPriority_t highest_ready_priority = rtosGetHighestReadyPriority();
-
   // Check if a context switch is required
-  if (rtos_running_task->state != RTOS_TASK_RUNNING || highest_ready_priority > rtos_running_task->priority
-      || (highest_ready_priority == rtos_running_task->priority
-          && (rtos_ticks - last_switch_ticks) >= SCHEDULER_TIMESLICE)) {
-    last_switch_ticks = rtos_ticks;
-
-    // If the current task is being preempted, append the current task to the end of the appropriate ready queue
-    // TODO: Should this block be in rtosInvokeScheduler or in rtosPerformContextSwitch?
-    if (rtos_running_task->state == RTOS_TASK_RUNNING) {
+  const bool context_switch = rtos_running_task->state != RTOS_TASK_RUNNING
+                              || highest_ready_priority > rtos_running_task->priority || equal_priority_switch;
+  if (context_switch) {
+
+    // If the current task is being preempted with time left in its timeslice, return it to the head of its ready queue
+    // so it resumes the remainder. Otherwise, refill its timeslice and append it to the tail. This is done here so that
+    // PendSV only has to pop the next ready task
+    if (rtos_running_task->state == RTOS_TASK_RUNNING && rtos_running_task->quantum_ticks != 0) {
       rtos_running_task->state = RTOS_TASK_READY;
-      rtosInsertTaskListTail(rtosGetReadyTaskQueue(rtos_running_task->priority), rtos_running_task);
+      rtosInsertReadyTaskHead(rtos_running_task);
+    } else {
+      rtos_running_task->quantum_ticks = rtosGetTimeslice(rtos_running_task);
+      if (rtos_running_task->state == RTOS_TASK_RUNNING) {
+        rtos_running_task->state = RTOS_TASK_READY;
+        rtosInsertReadyTaskTail(rtos_running_task);
+      }
     }
+  }
+
+  rtosExitCritical();
 
-    // Invoke the PendSV exception to perform the context switch
-    popR4R10();
+  // Invoke the PendSV exception to perform the context switch
+  if (context_switch) {
     SCB->ICSR |= SCB_ICSR_PENDSVSET_Msk;
     asm("ISB");
     asm("DSB");
-    pushR4R10();
   }
 }
 
-/**
- * Perform a context switch to the task stored in next_task
- */
-void rtosPerformContextSwitch(void) {
-  popR4R6();
-  rtos_running_task->stack_pointer = rtosStoreContext();
-
-  // Set the running task to the next ready task
-  rtos_running_task        = rtosPopTaskListHead(rtosGetReadyTaskQueue(rtosGetHighestReadyPriority()));
-  rtos_running_task->state = RTOS_TASK_RUNNING;
-
-  rtosRestoreContext(rtos_running_task->stack_pointer);
-  pushR4R6();
-}
-
 /**
  * Pass control to the next ready task
  *
  * If there is a ready task with the same priority as the running task, pass control. This is analogous to forcing the
  * scheduler timeslice to expire immediately. If there is no ready task with the same priority, the current task
  * continues execution and no context switch occurs.
+ *
+ * @return  - RTOS_OK               on success
+ *          - RTOS_ERROR_RESOURCE   if the running task holds the scheduler lock, in which case it does not yield
  */
 rtosStatus_t rtosYield(void) {
+  if (rtos_running_task->scheduler_lock != 0) {
+    return RTOS_ERROR_RESOURCE;
+  }
+
+  rtosEnterCritical();
   if (rtosGetReadyTask(rtos_running_task->priority) != NULL) {
     rtos_running_task->state = RTOS_TASK_READY;
-    rtosInsertTaskListTail(rtosGetReadyTaskQueue(rtos_running_task->priority), rtos_running_task);
+    rtosInsertReadyTaskTail(rtos_running_task);
     rtosInvokeScheduler();
   }
+  rtosExitCritical();
   return RTOS_OK;
 }
 
@@ -209,75 +406,92 @@ rtosStatus_t rtosYield(void) {
  * @param ticks the number of systicks to delay
  */
 rtosStatus_t rtosDelay(uint32_t ticks) {
-  return rtosDelayUntil(rtos_ticks + ticks);
+  return rtosDelayUntil(rtosGetSysTickCount64() + ticks);
 }
 
 /**
  * Block the current task until the systick count reaches the specified value
  *
+ * If the specified wake time is not in the future, the task continues execution without blocking.
+ *
  * @param ticks the wakeup time
  */
-rtosStatus_t rtosDelayUntil(uint32_t ticks) {
-  const uint32_t const_rtos_ticks = rtos_ticks;
+rtosStatus_t rtosDelayUntil(rtosTicks_t ticks) {
+  rtosEnterCritical();
 
-  __disable_irq();
+  if (ticks <= rtos_ticks) {
+    rtosExitCritical();
+    return RTOS_OK;
+  }
 
-  rtos_running_task->wake_time_ticks = ticks;
-  rtos_running_task->state           = RTOS_TASK_BLOCKED;
+  // Add the current task to the timeout list
+  rtos_running_task->state = RTOS_TASK_BLOCKED;
+  rtosTimeoutInsert(rtos_running_task, ticks);
 
-  // Add the current task to the list of delayed tasks, in order of wake time
-  if (rtos_delayed_tasks == NULL) {
-    rtos_delayed_tasks = rtos_running_task;
-  } else {
+  rtosExitCritical();
+  rtosInvokeScheduler();
+  return RTOS_OK;
+}
 
-    // No overflow
-    if (ticks > const_rtos_ticks) {
+/**
+ * Complete the current job of the running periodic task, and block until the release of its next job
+ *
+ * The release time advances by exactly one period each call, so releases do not drift. If the next release time has
+ * already passed, the task continues immediately.
+ *
+ * Records the completed job in the task's periodic statistics: whether it missed its deadline and by how much, and
+ * whether it overran into the next period. On resuming, also records the release jitter of the next job.
+ *
+ * @return  - RTOS_OK     on success
+ *          - RTOS_ERROR  if the running task is not periodic
+ */
+rtosStatus_t rtosWaitForNextPeriod(void) {
+  rtosTaskHandle_t     task  = rtos_running_task;
+  rtosPeriodicStats_t* stats = &task->periodic_stats;
 
-      // Insert at front
-      if (rtos_delayed_tasks->wake_time_ticks >= ticks) {
-        rtosInsertTaskListHead(&rtos_delayed_tasks, rtos_running_task);
-      }
+  if (task->period_ticks == 0) {
+    return RTOS_ERROR;
+  }
 
-      // Insert elsewhere
-      else {
+  rtosEnterCritical();
 
-        rtosTaskHandle_t cur_task = rtos_delayed_tasks;
-        while (cur_task->next != NULL && cur_task->next->wake_time_ticks < ticks) {
-          cur_task = cur_task->next;
-        }
-        rtosInsertTaskListHead(&cur_task->next, rtos_running_task);
-      }
+  // Record the completion of the current job
+  const rtosTicks_t completion_ticks = rtos_ticks;
+  stats->jobs++;
+  if (completion_ticks > task->abs_deadline_ticks) {
+    const uint32_t lateness = (uint32_t)(completion_ticks - task->abs_deadline_ticks);
+    stats->deadline_misses++;
+    if (lateness > stats->max_lateness) {
+      stats->max_lateness = lateness;
     }
-    // Overflow
-    else {
-
-      // Insert at front
-      if (rtos_delayed_tasks->wake_time_ticks < const_rtos_ticks && rtos_delayed_tasks->wake_time_ticks >= ticks) {
-        rtosInsertTaskListHead(&rtos_delayed_tasks, rtos_running_task);
-      }
+  }
 
-      // Insert elsewhere
-      else {
+  // Release the next job
+  task->release_ticks += task->period_ticks;
+  task->abs_deadline_ticks = task->release_ticks + (task->deadline_ticks != 0 ? task->deadline_ticks
+                                                                               : task->period_ticks);
+  if (completion_ticks > task->release_ticks) {
+    stats->overruns++;
+  }
 
-        // Consume all non-overflowed wake times
-        rtosTaskHandle_t cur_task = rtos_delayed_tasks;
-        if (cur_task->wake_time_ticks > const_rtos_ticks) {
-          while (cur_task->next != NULL && cur_task->next->wake_time_ticks < const_rtos_ticks) {
-            cur_task = cur_task->next;
-          }
-        }
+  rtosExitCritical();
 
-        // cur_task currently either points to the first overflowed or the last non-overflowed
-        while (cur_task->next != NULL && cur_task->next->wake_time_ticks < ticks) {
-          cur_task = cur_task->next;
-        }
+  // If the next job is already released, continue immediately. Another task may now have an earlier deadline
+  rtosStatus_t status = RTOS_OK;
+  if (task->release_ticks <= completion_ticks) {
+    rtosInvokeScheduler();
+  } else {
+    status = rtosDelayUntil(task->release_ticks);
+  }
 
-        rtosInsertTaskListHead(&cur_task->next, rtos_running_task);
-      }
+  // Record how long after its release the next job started
+  const rtosTicks_t start_ticks = rtosGetSysTickCount64();
+  if (start_ticks > task->release_ticks) {
+    const uint32_t jitter = (uint32_t)(start_ticks - task->release_ticks);
+    if (jitter > stats->max_release_jitter) {
+      stats->max_release_jitter = jitter;
     }
   }
 
-  __enable_irq();
-  rtosInvokeScheduler();
-  return RTOS_OK;
+  return status;
 }
@@ -9,17 +9,38 @@
 #include "globals.h"
 #include "task.h"
 
+#include <stdbool.h>
+
+/// The default round-robin timeslice, in ticks, of every priority
 #define SCHEDULER_TIMESLICE 5
 
-rtosPriority_t    rtosGetHighestReadyPriority(void);
-rtosTaskHandle_t* rtosGetReadyTaskQueue(rtosPriority_t priority);
-rtosTaskHandle_t  rtosGetReadyTask(rtosPriority_t priority);
+/// The priority at which earliest-deadline-first tasks run. Ready tasks at this priority are ordered by deadline
+#define SCHEDULER_EDF_PRIORITY RTOS_PRIORITY_HIGH
+
+rtosPriority_t   rtosGetHighestReadyPriority(void);
+rtosTaskList_t*  rtosGetReadyTaskQueue(rtosPriority_t priority);
+rtosTaskHandle_t rtosGetReadyTask(rtosPriority_t priority);
+void             rtosInsertReadyTaskHead(rtosTaskHandle_t task);
+void             rtosInsertReadyTaskTail(rtosTaskHandle_t task);
+rtosTaskHandle_t rtosPopReadyTask(rtosPriority_t priority);
+void             rtosRemoveReadyTask(rtosTaskHandle_t task);
+void             rtosChangeTaskPriority(rtosTaskHandle_t task, rtosPriority_t priority);
+void             rtosUnblockTask(rtosTaskHandle_t task, rtosStatus_t status);
+bool             rtosDeadlineBefore(rtosTaskHandle_t a, rtosTaskHandle_t b);
+
+uint32_t     rtosGetTimeslice(rtosTaskHandle_t task);
+rtosStatus_t rtosSetPriorityTimeslice(rtosPriority_t priority, uint32_t ticks);
+rtosStatus_t rtosTaskSetTimeslice(rtosTaskHandle_t task, uint32_t ticks);
+
+rtosStatus_t rtosSchedulerLock(void);
+rtosStatus_t rtosSchedulerUnlock(void);
 
+void rtosSchedulerTick(void);
 void rtosInvokeScheduler(void);
-void rtosPerformContextSwitch(void);
 
 rtosStatus_t rtosYield(void);
 rtosStatus_t rtosDelay(uint32_t ticks);
-rtosStatus_t rtosDelayUntil(uint32_t ticks);
+rtosStatus_t rtosDelayUntil(rtosTicks_t ticks);
+rtosStatus_t rtosWaitForNextPeriod(void);
 
 #endif  // __RTOS_SCHEDULER_H
@@ -0,0 +1,32 @@
+/**
+ * Memory placement of kernel data
+ * @author Matt Reynolds
+ * @author Dawson Hemphill
+ */
+#ifndef __RTOS_SECTIONS_H
+#define __RTOS_SECTIONS_H
+
+/// If nonzero, kernel-managed RAM (the stack arena) is placed in the 32 KiB AHB SRAM bank (IRAM2) at 0x2007C000 rather
+/// than the main SRAM bank, and the arena grows to half of that bank. Off by default, since the AHB bank is where DMA
+/// and peripheral buffers usually live, and those should not contend with task stacks. Enable it when the main bank is
+/// short of room for stacks
+#ifndef RTOS_USE_AHB_SRAM
+#define RTOS_USE_AHB_SRAM 0
+#endif
+
+/// Place a zero-initialized variable in the AHB SRAM bank. The scatter file maps the AHB_SRAM section to RW_IRAM2.
+/// Applications can use this for their own buffers, e.g. DMA buffers that should not contend with task stacks
+#if defined(__CC_ARM)
+#define RTOS_AHB_SRAM __attribute__((section("AHB_SRAM"), zero_init))
+#else
+#define RTOS_AHB_SRAM __attribute__((section(".bss.AHB_SRAM")))
+#endif
+
+/// Place kernel-managed RAM according to RTOS_USE_AHB_SRAM
+#if RTOS_USE_AHB_SRAM
+#define RTOS_KERNEL_RAM RTOS_AHB_SRAM
+#else
+#define RTOS_KERNEL_RAM
+#endif
+
+#endif  // __RTOS_SECTIONS_H
@@ -4,6 +4,7 @@
  * @author Dawson Hemphill
  */
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
 
@@ -13,12 +14,51 @@
 
 rtosSemaphoreHandle_t rtos_semaphores = NULL;
 
+/**
+ * Try to decrement the specified semaphore with a single exclusive store, without masking interrupts
+ *
+ * Any exception between the load and the store clears the exclusive monitor, so the store fails and is retried if
+ * another task could have run in between.
+ *
+ * @returns true if the semaphore was available and has been decremented
+ */
+static bool rtosSemaphoreTryAcquire(rtosSemaphoreHandle_t semaphore) {
+  uint32_t count;
+  do {
+    count = __LDREXW(&semaphore->count);
+    if (count == 0) {
+      __CLREX();
+      return false;
+    }
+  } while (__STREXW(count - 1, &semaphore->count) != 0);
+  return true;
+}
+
+/**
+ * Try to increment the specified semaphore with a single exclusive store, without masking interrupts
+ *
+ * @returns true if no tasks were blocked on the semaphore and it has been incremented
+ */
+static bool rtosSemaphoreTryRelease(rtosSemaphoreHandle_t semaphore) {
+  uint32_t count;
+  do {
+    count = __LDREXW(&semaphore->count);
+    if (count == semaphore->max || semaphore->blocked.list.head != NULL) {
+      __CLREX();
+      return false;
+    }
+  } while (__STREXW(count + 1, &semaphore->count) != 0);
+  return true;
+}
+
 /**
  * Create a new semaphore
  *
+ * With RTOS_SEMAPHORE_PRIO_ORDER, blocked tasks acquire the semaphore in order of priority rather than in FIFO order.
+ *
  * @param max       The maximum value the semaphore can hold
  * @param init      The initial value of the semaphore
- * @param attrs     Any additional semaphore attributes
+ * @param attrs     Any additional semaphore attributes, or NULL for the defaults
  * @param semaphore The semaphore object to initialize
  *
  * @return  - RTOS_OK               on success
@@ -34,11 +74,17 @@ rtosStatus_t rtosSemaphoreNew(uint32_t                   max,
     return RTOS_ERROR_PARAMETER;
   }
 
+  // With no attributes, blocked tasks acquire the semaphore in FIFO order
+  static const rtosSemaphoreAttr_t default_attrs = {NULL, 0};
+  if (attrs == NULL) {
+    attrs = &default_attrs;
+  }
+
   // Initialize the semaphore struct fields
-  semaphore->name    = attrs->name;
-  semaphore->count   = init;
-  semaphore->max     = max;
-  semaphore->blocked = NULL;
+  semaphore->name  = attrs->name;
+  semaphore->count = init;
+  semaphore->max   = max;
+  rtosWaitQueueInit(&semaphore->blocked, attrs->attr_bits & RTOS_SEMAPHORE_PRIO_ORDER);
 
   // Add the semaphore to the global list of semaphores
   semaphore->next = rtos_semaphores;
@@ -76,13 +122,12 @@ rtosStatus_t rtosSemaphoreDelete(rtosSemaphoreHandle_t semaphore) {
   }
 
   // Unblock all blocked tasks
-  // NOTE: Tasks unblocked via semaphore deletion return a unique error since the semaphore never became available
-  __disable_irq();
-  while (semaphore->blocked != NULL) {
-    rtosTaskHandle_t unblocked = rtosPopTaskListHead(&semaphore->blocked);
-    rtosInsertTaskListTail(rtosGetReadyTaskQueue(unblocked->priority), unblocked);
+  // NOTE: Tasks unblocked via semaphore deletion return RTOS_ERROR since the semaphore never became available
+  rtosEnterCritical();
+  while (semaphore->blocked.list.head != NULL) {
+    rtosUnblockTask(semaphore->blocked.list.head, RTOS_ERROR);
   }
-  __enable_irq();
+  rtosExitCritical();
 
   rtosInvokeScheduler();
 
@@ -93,7 +138,7 @@ rtosStatus_t rtosSemaphoreDelete(rtosSemaphoreHandle_t semaphore) {
  * Attempt to acquire (decrement) the specified semaphore
  *
  * @return  - RTOS_OK               on success
- *          - RTOS_ERROR            if the semaphore was deleted while trying to acquire it
+ *          - RTOS_ERROR            if the semaphore was deleted, or the task was suspended, while trying to acquire it
  *          - RTOS_ERROR_TIMEOUT    if the semaphore could not be acquired in the specified timeout
  *          - RTOS_ERROR_PARAMETER  if the semaphore is NULL or invalid
  *          - RTOS_ERROR_RESOURCE   if the semaphore could not be acquired and no timeout was specified
@@ -105,60 +150,42 @@ rtosStatus_t rtosSemaphoreAcquire(rtosSemaphoreHandle_t semaphore, uint32_t time
     return RTOS_ERROR_PARAMETER;
   }
 
-  // Disable interrupts to ensure count is read and written atomically
-  __disable_irq();
-
-  // Timeout value is set to zero so try once and then exit
-  if (timeout == 0) {
-    if (semaphore->count == 0) {
-      __enable_irq();
-      return RTOS_ERROR_RESOURCE;
-    }
-
-    semaphore->count--;
-    __enable_irq();
+  // If the semaphore is available, acquire it without entering the kernel
+  if (rtosSemaphoreTryAcquire(semaphore)) {
     return RTOS_OK;
   }
 
-  // Timeout value is set to forever so block until the semaphore is available
-  else if (timeout == RTOS_WAIT_FOREVER) {
+  // Enter a critical section to ensure count is read and written atomically
+  rtosEnterCritical();
 
-    // If the semaphore is unavailable, block the current task
-    while (semaphore->count == 0) {
-      rtos_running_task->state = RTOS_TASK_BLOCKED;
-      rtosInsertTaskListTail(&semaphore->blocked, rtos_running_task);
-
-      __enable_irq();
-      rtosInvokeScheduler();
-      __disable_irq();
-    }
-
-    // Once the semaphore is available, acquire it
+  // If the semaphore is available, acquire it
+  if (semaphore->count > 0) {
     semaphore->count--;
-    __enable_irq();
+    rtosExitCritical();
     return RTOS_OK;
-
   }
 
-  // Timeout value is a given number of ticks, block until the semaphore is available or the timeout expires
-  else {
+  // Timeout value is set to zero so don't wait
+  if (timeout == 0) {
+    rtosExitCritical();
+    return RTOS_ERROR_RESOURCE;
+  }
 
-    // If the semaphore is unavailable, block the current task
-    while (semaphore->count == 0) {
-      rtos_running_task->state           = RTOS_TASK_BLOCKED_TIMEOUT;
-      rtos_running_task->wake_time_ticks = rtosGetSysTickCount() + timeout;
-      rtosInsertTaskListTail(&semaphore->blocked, rtos_running_task);
+  // Otherwise, block the current task until a release hands it the semaphore, the timeout expires, or the semaphore is
+  // deleted
+  if (timeout == RTOS_WAIT_FOREVER) {
+    rtos_running_task->state = RTOS_TASK_BLOCKED;
+  } else {
+    rtos_running_task->state = RTOS_TASK_BLOCKED_TIMEOUT;
+    rtosTimeoutInsert(rtos_running_task, rtos_ticks + timeout);
+  }
+  rtosWaitQueueInsert(&semaphore->blocked, rtos_running_task);
 
-      __enable_irq();
-      rtosInvokeScheduler();
-      __disable_irq();
-    }
+  rtosExitCritical();
+  rtosInvokeScheduler();
 
-    // Once the semaphore is available, acquire it
-    semaphore->count--;
-    __enable_irq();
-    return RTOS_OK;
-  }
+  // A release hands the semaphore directly to the woken task, so there is nothing left to acquire
+  return rtos_running_task->wake_status;
 }
 
 /**
@@ -175,29 +202,58 @@ rtosStatus_t rtosSemaphoreRelease(rtosSemaphoreHandle_t semaphore) {
     return RTOS_ERROR_PARAMETER;
   }
 
-  // Disable interrupts
-  __disable_irq();
+  // If no tasks are blocked on the semaphore, release it without entering the kernel
+  if (rtosSemaphoreTryRelease(semaphore)) {
+    return RTOS_OK;
+  }
+
+  // Enter a critical section
+  rtosEnterCritical();
 
   // Ensure the maximum value has not been reached
   if (semaphore->count == semaphore->max) {
-    __enable_irq();
+    rtosExitCritical();
     return RTOS_ERROR_RESOURCE;
   }
 
-  // Increment the count
-  semaphore->count++;
+  // If there are blocked tasks, hand the semaphore directly to the first task in the queue. It returns from its acquire
+  // without decrementing the count, so no other task can take the semaphore first. Otherwise, increment the count
+  if (semaphore->blocked.list.head != NULL) {
+    rtosUnblockTask(semaphore->blocked.list.head, RTOS_OK);
 
-  // If there are blocked tasks, unblock the first task in the queue
-  if (semaphore->blocked != NULL) {
-    rtosTaskHandle_t unblocked = rtosPopTaskListHead(&semaphore->blocked);
-    unblocked->state           = RTOS_TASK_READY;
-    rtosInsertTaskListTail(rtosGetReadyTaskQueue(unblocked->priority), unblocked);
-
-    __enable_irq();
+    rtosExitCritical();
     rtosInvokeScheduler();
-    __disable_irq();
+    return RTOS_OK;
   }
 
-  __enable_irq();
+  semaphore->count++;
+  rtosExitCritical();
   return RTOS_OK;
 }
+
+/**
+ * Release the specified semaphore on behalf of an ISR, once PendSV runs
+ */
+static void rtosSemaphoreReleaseDeferred(void* semaphore) {
+  rtosSemaphoreRelease((rtosSemaphoreHandle_t) semaphore);
+}
+
+/**
+ * Release (increment) the specified semaphore from an ISR
+ *
+ * The release is deferred to PendSV, which runs as soon as every active ISR has returned. If the semaphore is already
+ * at its maximum value by then, the release has no effect.
+ *
+ * @return  - RTOS_OK               on success
+ *          - RTOS_ERROR_RESOURCE   if too many operations have been deferred from ISRs since PendSV last ran
+ *          - RTOS_ERROR_PARAMETER  if the semaphore is NULL or invalid
+ */
+rtosStatus_t rtosSemaphoreReleaseFromISR(rtosSemaphoreHandle_t semaphore) {
+
+  // Ensure the semaphore handle is valid
+  if (semaphore == NULL) {
+    return RTOS_ERROR_PARAMETER;
+  }
+
+  return rtosDeferFromISR(rtosSemaphoreReleaseDeferred, semaphore);
+}
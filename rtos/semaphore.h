@@ -10,11 +10,15 @@
 
 #include "status.h"
 #include "task.h"
+#include "waitqueue.h"
+
+// Define semaphore attribute options
+#define RTOS_SEMAPHORE_PRIO_ORDER 0x00000010U
 
 /// Semaphore attributes
 typedef struct {
   const char* name;
-  // uint32_t attr_bits;  // Unused
+  uint32_t    attr_bits;
 } rtosSemaphoreAttr_t;
 
 /// Semaphore
@@ -22,7 +26,7 @@ typedef struct rtosSemaphore_tag {
   const char*               name;     ///< The name of semaphore
   uint32_t                  count;    ///< The current semaphore value
   uint32_t                  max;      ///< The max semaphore value
-  rtosTaskHandle_t          blocked;  ///< The list of tasks blocked by the semaphore
+  rtosWaitQueue_t           blocked;  ///< The tasks blocked by the semaphore
   struct rtosSemaphore_tag* next;     ///< The next semaphore in the global list
 } rtosSemaphore_t;
 
@@ -35,5 +39,6 @@ rtosStatus_t rtosSemaphoreNew(uint32_t                   max,
 rtosStatus_t rtosSemaphoreDelete(rtosSemaphoreHandle_t semaphore);
 rtosStatus_t rtosSemaphoreAcquire(rtosSemaphoreHandle_t semaphore, uint32_t timeout);
 rtosStatus_t rtosSemaphoreRelease(rtosSemaphoreHandle_t semaphore);
+rtosStatus_t rtosSemaphoreReleaseFromISR(rtosSemaphoreHandle_t semaphore);
 
 #endif  // __RTOS_SEMAPHORE_H
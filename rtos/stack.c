@@ -0,0 +1,264 @@
+/**
+ * Task stack arena implementation
+ *
+ * Task stacks that are not provided by the caller are carved out of a single static arena. Free space is kept in a
+ * list of free blocks ordered by address, with each block's size and link stored in the block itself. Allocation is
+ * first-fit, and freed blocks are merged with adjacent free blocks so that the arena does not fragment as tasks come
+ * and go.
+ *
+ * New stacks are filled with a known pattern. The high-water mark of a stack is found by scanning up from its lowest
+ * address for the first word that no longer holds the pattern, and the lowest word doubles as a canary that is checked
+ * for overflow each time the task is switched out.
+ *
+ * With RTOS_MPU_STACK_GUARD, one MPU region covers the first RTOS_STACK_GUARD_SIZE-aligned block of the running task's
+ * stack and denies all access to it. Arena stacks are allocated RTOS_STACK_GUARD_OVERHEAD bytes larger to make room
+ * for it, so the guard never takes from the usable size that was requested. The region's size and attributes never
+ * change, so PendSV moves it to the incoming task with a single write to the region base address register.
+ *
+ * @author Matt Reynolds
+ * @author Dawson Hemphill
+ */
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include <LPC17xx.h>
+
+#include "critical.h"
+#include "globals.h"
+#include "stack.h"
+
+/// A free block in the stack arena
+typedef struct rtosStackBlock_tag {
+  uint32_t                   size;  ///< The size of the block, in bytes
+  struct rtosStackBlock_tag* next;  ///< The next free block, at a higher address
+} rtosStackBlock_t;
+
+RTOS_KERNEL_RAM __attribute__((aligned(RTOS_STACK_ALIGN))) uint8_t rtos_stack_arena[RTOS_STACK_ARENA_SIZE];
+
+rtosStackBlock_t* rtos_stack_free_list   = NULL;   // Ordered by address
+bool              rtos_stack_arena_ready = false;  // Whether the free list has been initialized
+
+/**
+ * Make the whole arena a single free block, the first time the arena is used
+ */
+static void rtosStackArenaInit(void) {
+  if (!rtos_stack_arena_ready) {
+    rtos_stack_free_list       = (rtosStackBlock_t*) rtos_stack_arena;
+    rtos_stack_free_list->size = RTOS_STACK_ARENA_SIZE & ~(RTOS_STACK_ALIGN - 1);
+    rtos_stack_free_list->next = NULL;
+    rtos_stack_arena_ready     = true;
+  }
+}
+
+/**
+ * Allocate a task stack from the arena
+ *
+ * @param size  The size of the stack, in bytes. Must be a multiple of RTOS_STACK_ALIGN
+ *
+ * @returns The lowest address of the stack, or NULL if no free block is large enough
+ */
+void* rtosStackAlloc(uint32_t size) {
+  void* stack = NULL;
+
+  rtosEnterCritical();
+  rtosStackArenaInit();
+
+  // Find the first free block that is large enough, and take the stack from its start
+  rtosStackBlock_t** link = &rtos_stack_free_list;
+  while (*link != NULL && (*link)->size < size) {
+    link = &(*link)->next;
+  }
+
+  if (*link != NULL) {
+    rtosStackBlock_t* block = *link;
+    stack                   = block;
+
+    // Split off the remainder, if it is large enough to hold a free block
+    if (block->size - size >= sizeof(rtosStackBlock_t)) {
+      rtosStackBlock_t* rest = (rtosStackBlock_t*) ((uint8_t*) block + size);
+      rest->size             = block->size - size;
+      rest->next             = block->next;
+      *link                  = rest;
+    } else {
+      *link = block->next;
+    }
+  }
+
+  rtosExitCritical();
+  return stack;
+}
+
+/**
+ * Return a task stack to the arena
+ *
+ * @param stack The lowest address of the stack, as returned by rtosStackAlloc()
+ * @param size  The size that was allocated, in bytes
+ */
+void rtosStackFree(void* stack, uint32_t size) {
+  rtosStackBlock_t* block = (rtosStackBlock_t*) stack;
+
+  rtosEnterCritical();
+
+  // Find the free blocks either side of the stack
+  rtosStackBlock_t*  prev = NULL;
+  rtosStackBlock_t** link = &rtos_stack_free_list;
+  while (*link != NULL && *link < block) {
+    prev = *link;
+    link = &(*link)->next;
+  }
+
+  // Link the block in, merging it with the next free block if they are adjacent
+  block->size = size;
+  block->next = *link;
+  if (block->next != NULL && (uint8_t*) block + block->size == (uint8_t*) block->next) {
+    block->size += block->next->size;
+    block->next = block->next->next;
+  }
+  *link = block;
+
+  // Merge the previous free block with the block if they are adjacent
+  if (prev != NULL && (uint8_t*) prev + prev->size == (uint8_t*) block) {
+    prev->size += block->size;
+    prev->next = block->next;
+  }
+
+  rtosExitCritical();
+}
+
+/**
+ * Get the total number of free bytes in the stack arena
+ */
+uint32_t rtosStackArenaFree(void) {
+  uint32_t free_bytes = 0;
+
+  rtosEnterCritical();
+  rtosStackArenaInit();
+  for (rtosStackBlock_t* block = rtos_stack_free_list; block != NULL; block = block->next) {
+    free_bytes += block->size;
+  }
+  rtosExitCritical();
+
+  return free_bytes;
+}
+
+/**
+ * Prepare a new task stack for usage measurement and the overflow check
+ *
+ * With RTOS_STACK_FILL, the whole stack is filled with RTOS_STACK_FILL_PATTERN. Otherwise, only the lowest word is.
+ *
+ * @param stack_base  The lowest address of the stack
+ * @param stack_size  The size of the stack, in bytes
+ */
+void rtosStackFill(uint32_t stack_base, uint32_t stack_size) {
+#if RTOS_STACK_FILL
+  for (uint32_t* word = (uint32_t*) stack_base; word < (uint32_t*) (stack_base + stack_size); word++) {
+    *word = RTOS_STACK_FILL_PATTERN;
+  }
+#else
+  *(uint32_t*) stack_base = RTOS_STACK_FILL_PATTERN;
+#endif
+}
+
+/**
+ * Get the lowest usable address of the specified task's stack
+ *
+ * With RTOS_MPU_STACK_GUARD, this is the address just above the guard. Otherwise, it is the lowest address of the
+ * stack.
+ */
+uint32_t rtosStackLimit(rtosTaskHandle_t task) {
+#if RTOS_MPU_STACK_GUARD
+  return ((task->stack_base + RTOS_STACK_GUARD_SIZE - 1) & ~(RTOS_STACK_GUARD_SIZE - 1)) + RTOS_STACK_GUARD_SIZE;
+#else
+  return task->stack_base;
+#endif
+}
+
+/**
+ * Check the stack of a task that has just been switched out
+ *
+ * The stack has overflowed if the saved stack pointer is below the stack, or if the canary at the lowest word of the
+ * stack has been overwritten. This costs one comparison and one load per switch, and catches most overflows before
+ * the overwritten memory is next used. With RTOS_MPU_STACK_GUARD, the canary may lie inside the guard, so only the
+ * stack pointer is checked.
+ */
+void rtosStackCheck(rtosTaskHandle_t task) {
+#if RTOS_MPU_STACK_GUARD
+  if (task->stack_pointer < rtosStackLimit(task)) {
+    rtosStackOverflow(task);
+  }
+#else
+  if (task->stack_pointer <= task->stack_base || *(uint32_t*) task->stack_base != RTOS_STACK_FILL_PATTERN) {
+    rtosStackOverflow(task);
+  }
+#endif
+}
+
+/**
+ * Configure the MPU stack guard for the first task and enable the MPU
+ *
+ * The default memory map stays in effect for everything outside the guard. MemManage faults are enabled so that an
+ * overflow is reported as a MemManage fault rather than escalating to a HardFault.
+ */
+void rtosStackGuardInit(rtosTaskHandle_t task) {
+  MPU->RBAR = (rtosStackLimit(task) - RTOS_STACK_GUARD_SIZE) | MPU_RBAR_VALID_Msk | RTOS_STACK_GUARD_REGION;
+
+  // No access even when privileged, never execute, and 2^(4 + 1) = 32 bytes
+  MPU->RASR = (1UL << MPU_RASR_XN_Pos) | (0UL << MPU_RASR_AP_Pos) | (4UL << MPU_RASR_SIZE_Pos) | MPU_RASR_ENABLE_Msk;
+
+  MPU->CTRL  = MPU_CTRL_PRIVDEFENA_Msk | MPU_CTRL_ENABLE_Msk;
+  SCB->SHCSR |= SCB_SHCSR_MEMFAULTENA_Msk;
+  __DSB();
+  __ISB();
+}
+
+/**
+ * Called when a task's stack is found to have overflowed
+ *
+ * The memory below the stack has already been corrupted, so the default implementation halts with interrupts disabled,
+ * leaving the task in rtos_running_task for the debugger. The application can override it.
+ */
+__attribute__((weak)) void rtosStackOverflow(rtosTaskHandle_t task) {
+  __disable_irq();
+  while (1) {
+  }
+}
+
+/**
+ * Get the stack usage of the specified task
+ *
+ * The high-water mark is found by scanning the stack from its lowest usable address, so the time taken is proportional
+ * to the unused part of the stack. With RTOS_MPU_STACK_GUARD, the guard and anything below it count as used.
+ *
+ * @param task  The task to query
+ * @param usage The structure to copy the usage into
+ *
+ * @return  - RTOS_OK               on success
+ *          - RTOS_ERROR            if stacks are not filled (RTOS_STACK_FILL is 0), so the high-water mark is unknown
+ *          - RTOS_ERROR_PARAMETER  if the task or usage is NULL, or the task has no stack
+ */
+rtosStatus_t rtosTaskGetStackUsage(rtosTaskHandle_t task, rtosStackUsage_t* usage) {
+  if (task == NULL || usage == NULL || task->stack_size == 0) {
+    return RTOS_ERROR_PARAMETER;
+  }
+
+  rtosEnterCritical();
+
+  const uint32_t stack_top = task->stack_base + task->stack_size;
+  usage->size              = stack_top - rtosStackLimit(task);
+  usage->used              = stack_top - ((task == rtos_running_task) ? __get_PSP() : task->stack_pointer);
+
+  const uint32_t* word = (const uint32_t*) rtosStackLimit(task);
+  while (word < (const uint32_t*) stack_top && *word == RTOS_STACK_FILL_PATTERN) {
+    word++;
+  }
+  usage->max_used = stack_top - (uint32_t) word;
+
+  rtosExitCritical();
+
+#if RTOS_STACK_FILL
+  return RTOS_OK;
+#else
+  return RTOS_ERROR;
+#endif
+}
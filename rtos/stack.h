@@ -0,0 +1,80 @@
+/**
+ * Task stacks
+ * @author Matt Reynolds
+ * @author Dawson Hemphill
+ */
+#ifndef __RTOS_STACK_H
+#define __RTOS_STACK_H
+
+#include <stdint.h>
+
+#include "sections.h"
+#include "task.h"
+
+/// The number of bytes reserved for task stacks allocated by the kernel. In the AHB SRAM bank, half of the bank is
+/// used, leaving the rest for memory pools and application buffers
+#ifndef RTOS_STACK_ARENA_SIZE
+#if RTOS_USE_AHB_SRAM
+#define RTOS_STACK_ARENA_SIZE 0x4000
+#else
+#define RTOS_STACK_ARENA_SIZE 0x1800
+#endif
+#endif
+
+/// The alignment of every task stack, as required by the procedure call standard
+#define RTOS_STACK_ALIGN 8
+
+/// If nonzero, new task stacks are filled with RTOS_STACK_FILL_PATTERN so that their high-water mark can be measured.
+/// Otherwise, only the lowest word of each stack is written, as a canary for the overflow check
+#ifndef RTOS_STACK_FILL
+#define RTOS_STACK_FILL 1
+#endif
+
+/// The value written to unused stack words
+#define RTOS_STACK_FILL_PATTERN 0xA5A5A5A5U
+
+/// If nonzero, the outgoing task's stack is checked for overflow on every context switch
+#ifndef RTOS_STACK_CHECK
+#define RTOS_STACK_CHECK 1
+#endif
+
+/// If nonzero, the MPU makes the lowest bytes of the running task's stack inaccessible, so that an overflow faults at
+/// the instruction that caused it rather than corrupting the memory below the stack
+#ifndef RTOS_MPU_STACK_GUARD
+#define RTOS_MPU_STACK_GUARD 0
+#endif
+
+/// The size of the MPU stack guard, in bytes. This is the smallest MPU region. Regions must be aligned to their size
+#define RTOS_STACK_GUARD_SIZE 32
+
+/// The most bytes the stack guard can take from the bottom of a stack: the guard, plus the padding below it that aligns
+/// it. Arena stacks are allocated this much larger than requested. Caller-provided stacks must include it
+#if RTOS_MPU_STACK_GUARD
+#define RTOS_STACK_GUARD_OVERHEAD (2 * RTOS_STACK_GUARD_SIZE - RTOS_STACK_ALIGN)
+#else
+#define RTOS_STACK_GUARD_OVERHEAD 0
+#endif
+
+/// The MPU region used for the stack guard. The highest-numbered region takes precedence where regions overlap
+#define RTOS_STACK_GUARD_REGION 7
+
+/// Task stack usage
+typedef struct {
+  uint32_t size;      ///< The usable size of the stack, in bytes, excluding any MPU stack guard
+  uint32_t used;      ///< The number of bytes in use when the task last stopped running
+  uint32_t max_used;  ///< The high-water mark: the most bytes the task has ever used
+} rtosStackUsage_t;
+
+void*    rtosStackAlloc(uint32_t size);
+void     rtosStackFree(void* stack, uint32_t size);
+uint32_t rtosStackArenaFree(void);
+
+void     rtosStackFill(uint32_t stack_base, uint32_t stack_size);
+uint32_t rtosStackLimit(rtosTaskHandle_t task);
+void     rtosStackCheck(rtosTaskHandle_t task);
+void     rtosStackOverflow(rtosTaskHandle_t task);
+void     rtosStackGuardInit(rtosTaskHandle_t task);
+
+rtosStatus_t rtosTaskGetStackUsage(rtosTaskHandle_t task, rtosStackUsage_t* usage);
+
+#endif  // __RTOS_STACK_H
@@ -6,16 +6,22 @@
 #ifndef __RTOS_STATUS_H
 #define __RTOS_STATUS_H
 
+#include <stdint.h>
+
+/// Kernel time, in ticks since the RTOS started. 64 bits wide so that it never wraps in practice
+typedef uint64_t rtosTicks_t;
+
 /// A special timeout value that informs the RTOS to never timeout.
 #define RTOS_WAIT_FOREVER 0xFFFFFFFFU
 
 /// Standard return status codes
 typedef enum {
-  RTOS_OK,               ///< Operation completed successfully
-  RTOS_ERROR,            ///< Unspecified runtime error
-  RTOS_ERROR_TIMEOUT,    ///< Operation not completed within timeout period
-  RTOS_ERROR_RESOURCE,   ///< Resource not available
-  RTOS_ERROR_PARAMETER,  ///< Parameter error
+  RTOS_OK,                ///< Operation completed successfully
+  RTOS_ERROR,             ///< Unspecified runtime error
+  RTOS_ERROR_TIMEOUT,     ///< Operation not completed within timeout period
+  RTOS_ERROR_RESOURCE,    ///< Resource not available
+  RTOS_ERROR_PARAMETER,   ///< Parameter error
+  RTOS_ERROR_OWNER_DIED,  ///< Resource acquired, but its previous owner was deleted while holding it
 } rtosStatus_t;
 
 #endif  // __RTOS_STATUS_H
@@ -7,10 +7,30 @@
 #include <stdlib.h>
 
 #include "globals.h"
+#include "rtos.h"
+#include "stack.h"
 #include "task.h"
 
 rtosTaskControlBlock_t rtos_tasks[MAX_TASKS];
 
+/// The last task that deleted itself while running on an arena stack, whose stack is not yet freed, or NULL if none
+static rtosTaskHandle_t rtos_zombie_task = NULL;
+
+/**
+ * Free the arena stack of the last task that deleted itself, if it has not been freed yet
+ *
+ * The task was running on the stack when it deleted itself, so the stack could not be freed then. Once any other task
+ * is running, it cannot run again. Only the last such task is kept, since each self-deletion reaps the one before, so
+ * this takes constant time. Must be called from within a critical section.
+ */
+static void rtosTaskReap(void) {
+  if (rtos_zombie_task != NULL) {
+    rtosStackFree((void*) rtos_zombie_task->stack_base, rtos_zombie_task->stack_size);
+    rtos_zombie_task->stack_from_arena = false;
+    rtos_zombie_task                   = NULL;
+  }
+}
+
 /**
  * Initialize all task control blocks
  */
@@ -29,12 +49,30 @@ void rtosTaskInit(uint32_t task_id) {
   rtosTaskHandle_t tcb_ref = &rtos_tasks[task_id];
 
   // Initialize the TCB
-  tcb_ref->id              = task_id;
-  tcb_ref->next            = NULL;
-  tcb_ref->priority        = RTOS_PRIORITY_NONE;
-  tcb_ref->state           = RTOS_TASK_INACTIVE;
-  tcb_ref->stack_pointer   = BASE_STACK_PTR - MAIN_STACK_SIZE - TASK_STACK_SIZE * tcb_ref->id;
-  tcb_ref->wake_time_ticks = 0;
+  tcb_ref->id               = task_id;
+  tcb_ref->list             = NULL;
+  tcb_ref->next             = NULL;
+  tcb_ref->prev             = NULL;
+  tcb_ref->priority         = RTOS_PRIORITY_NONE;
+  tcb_ref->base_priority    = RTOS_PRIORITY_NONE;
+  tcb_ref->held_mutexes     = NULL;
+  tcb_ref->blocked_on       = NULL;
+  tcb_ref->wait_queue       = NULL;
+  tcb_ref->state            = RTOS_TASK_INACTIVE;
+  tcb_ref->stack_pointer    = 0;
+  tcb_ref->stack_base       = 0;
+  tcb_ref->stack_size       = 0;
+  tcb_ref->stack_from_arena = false;
+  tcb_ref->wake_time_ticks  = 0;
+  tcb_ref->wake_status      = RTOS_OK;
+  tcb_ref->wake_data        = NULL;
+  tcb_ref->timeslice_ticks  = 0;
+  tcb_ref->quantum_ticks    = 0;
+  tcb_ref->scheduler_lock   = 0;
+  tcb_ref->period_ticks     = 0;
+  tcb_ref->deadline_ticks   = 0;
+  tcb_ref->timeout_next     = NULL;
+  tcb_ref->timeout_prev     = NULL;
 
   // Add the task to the inactive list
   rtosInsertTaskListHead(&rtos_inactive_tasks, tcb_ref);
@@ -46,12 +84,10 @@ void rtosTaskInit(uint32_t task_id) {
  * Terminates execution of the task and adds the task's control block back to the pool of available tasks.
  * Note that terminated tasks and inactive tasks are treated the same way in this RTOS.
  *
- * Analagous to a return statement at the end of the task function body.
+ * Analagous to a return statement at the end of the task function body. Equivalent to deleting the running task.
  */
 void rtosTaskExit(void) {
-  rtos_running_task->state = RTOS_TASK_TERMINATED;
-  rtosInsertTaskListTail(&rtos_inactive_tasks, rtos_running_task);
-  rtosInvokeScheduler();
+  rtosTaskDelete(rtos_running_task);
 }
 
 /**
@@ -67,14 +103,100 @@ void rtosTaskExit(void) {
  *          - RTOS_ERROR_PARAMETER if the function pointer is NULL
  */
 rtosStatus_t rtosTaskNew(rtosTaskFunc_t func, void* arg, rtosPriority_t priority, rtosTaskHandle_t* task) {
+  if (priority == RTOS_PRIORITY_NONE) {
+    priority = RTOS_PRIORITY_NORMAL;
+  }
 
-  if (rtos_inactive_tasks == NULL) {
-    *task = NULL;
-    return RTOS_ERROR_RESOURCE;
+  return rtosTaskCreate(func, arg, priority, 0, 0, 0, NULL, task);
+}
+
+/**
+ * Create a new task given the specified function, priority and stack
+ *
+ * @param func        The function that the task executes
+ * @param arg         The argument to pass to the function
+ * @param priority    The priority of the task. If NULL, default priority = RTOS_PRIORITY_NORMAL
+ * @param stack_size  The size of the stack, in bytes, or 0 for TASK_STACK_SIZE
+ * @param stack       The stack memory, aligned to RTOS_STACK_ALIGN, or NULL to allocate it from the stack arena
+ * @param task        A handle to the created task
+ *
+ * @return  - RTOS_OK on success
+ *          - RTOS_ERROR_RESOURCE if no more tasks can be created, or the stack arena is exhausted
+ *          - RTOS_ERROR_PARAMETER if the function pointer is NULL, or the stack is too small or misaligned
+ */
+rtosStatus_t rtosTaskNewStack(rtosTaskFunc_t    func,
+                              void*             arg,
+                              rtosPriority_t    priority,
+                              uint32_t          stack_size,
+                              void*             stack,
+                              rtosTaskHandle_t* task) {
+  if (priority == RTOS_PRIORITY_NONE) {
+    priority = RTOS_PRIORITY_NORMAL;
   }
 
-  if (func == NULL) {
-    *task = NULL;
+  return rtosTaskCreate(func, arg, priority, 0, 0, stack_size, stack, task);
+}
+
+/**
+ * Create a new earliest-deadline-first task given the specified function, deadline and period
+ *
+ * The task runs at SCHEDULER_EDF_PRIORITY, where ready tasks are dispatched in order of absolute deadline. The first
+ * job is released immediately. The task should call rtosWaitForNextPeriod() at the end of each job.
+ *
+ * @param func      The function that the task executes
+ * @param arg       The argument to pass to the function
+ * @param deadline  The deadline of each job, in ticks after its release
+ * @param period    The release period, in ticks
+ * @param task      A handle to the created task
+ *
+ * @return  - RTOS_OK on success
+ *          - RTOS_ERROR_RESOURCE if no more tasks can be created
+ *          - RTOS_ERROR_PARAMETER if the function pointer is NULL, or the deadline is 0 or longer than the period
+ */
+rtosStatus_t rtosTaskNewDeadline(rtosTaskFunc_t    func,
+                                 void*             arg,
+                                 uint32_t          deadline,
+                                 uint32_t          period,
+                                 rtosTaskHandle_t* task) {
+  if (deadline == 0 || deadline > period) {
+    if (task != NULL) {
+      *task = NULL;
+    }
+    return RTOS_ERROR_PARAMETER;
+  }
+
+  return rtosTaskCreate(func, arg, SCHEDULER_EDF_PRIORITY, deadline, period, 0, NULL, task);
+}
+
+/**
+ * Create a new fixed-priority periodic task given the specified function, priority and period
+ *
+ * The first job is released immediately and each job's deadline is the release of the next. The task should call
+ * rtosWaitForNextPeriod() at the end of each job, which also records deadline misses, overruns, lateness and release
+ * jitter. The statistics can be read with rtosTaskGetPeriodicStats().
+ *
+ * The deadline is only used for the statistics. The task is not scheduled by deadline, so it keeps FIFO order among the
+ * tasks of its priority, even at SCHEDULER_EDF_PRIORITY. Use rtosTaskNewDeadline() for earliest-deadline-first tasks.
+ *
+ * @param func      The function that the task executes
+ * @param arg       The argument to pass to the function
+ * @param priority  The priority of the task. If NULL, default priority = RTOS_PRIORITY_NORMAL
+ * @param period    The release period, in ticks
+ * @param task      A handle to the created task
+ *
+ * @return  - RTOS_OK on success
+ *          - RTOS_ERROR_RESOURCE if no more tasks can be created
+ *          - RTOS_ERROR_PARAMETER if the function pointer is NULL or the period is 0
+ */
+rtosStatus_t rtosTaskNewPeriodic(rtosTaskFunc_t    func,
+                                 void*             arg,
+                                 rtosPriority_t    priority,
+                                 uint32_t          period,
+                                 rtosTaskHandle_t* task) {
+  if (period == 0) {
+    if (task != NULL) {
+      *task = NULL;
+    }
     return RTOS_ERROR_PARAMETER;
   }
 
@@ -82,14 +204,114 @@ rtosStatus_t rtosTaskNew(rtosTaskFunc_t func, void* arg, rtosPriority_t priority
     priority = RTOS_PRIORITY_NORMAL;
   }
 
+  return rtosTaskCreate(func, arg, priority, 0, period, 0, NULL, task);
+}
+
+/**
+ * Create a new task, releasing its first job immediately
+ *
+ * @param func        The function that the task executes
+ * @param arg         The argument to pass to the function
+ * @param priority    The priority of the task
+ * @param deadline    The deadline of each job, in ticks after its release, or 0 if none
+ * @param period      The release period, in ticks, or 0 if the task is not periodic
+ * @param stack_size  The size of the stack, in bytes, or 0 for TASK_STACK_SIZE
+ * @param stack       The stack memory, aligned to RTOS_STACK_ALIGN, or NULL to allocate it from the stack arena
+ * @param task        A handle to the created task
+ *
+ * With RTOS_MPU_STACK_GUARD, the guard takes up to RTOS_STACK_GUARD_OVERHEAD bytes from the bottom of the stack. An
+ * arena stack is allocated that much larger than stack_size. A caller-provided stack must include the overhead in
+ * stack_size, and the rest is usable.
+ *
+ * @return  - RTOS_OK on success
+ *          - RTOS_ERROR_RESOURCE if no more tasks can be created, or the stack arena is exhausted
+ *          - RTOS_ERROR_PARAMETER if the function pointer is NULL, or the stack is too small or misaligned
+ */
+rtosStatus_t rtosTaskCreate(rtosTaskFunc_t    func,
+                            void*             arg,
+                            rtosPriority_t    priority,
+                            uint32_t          deadline,
+                            uint32_t          period,
+                            uint32_t          stack_size,
+                            void*             stack,
+                            rtosTaskHandle_t* task) {
+
+  if (task != NULL) {
+    *task = NULL;
+  }
+
+  if (stack_size == 0) {
+    stack_size = TASK_STACK_SIZE;
+  }
+
+  // Kernel-allocated stacks are rounded up to the stack alignment. Caller-provided stacks must already be aligned, and
+  // any trailing bytes beyond the alignment are unused
+  if (stack == NULL) {
+    stack_size = (stack_size + RTOS_STACK_ALIGN - 1) & ~(RTOS_STACK_ALIGN - 1);
+  } else {
+    stack_size &= ~(RTOS_STACK_ALIGN - 1);
+  }
+
+  // Make room for the stack guard below an arena stack, so the usable size is the size requested
+  if (stack == NULL) {
+    stack_size += RTOS_STACK_GUARD_OVERHEAD;
+  }
+
+  if (func == NULL || stack_size < TASK_STACK_MIN_SIZE + RTOS_STACK_GUARD_OVERHEAD
+      || ((uint32_t) stack & (RTOS_STACK_ALIGN - 1)) != 0) {
+    return RTOS_ERROR_PARAMETER;
+  }
+
+  rtosEnterCritical();
+
+  if (rtos_inactive_tasks.head == NULL) {
+    rtosExitCritical();
+    return RTOS_ERROR_RESOURCE;
+  }
+
+  // Free the stack of the last task that deleted itself, so it can be reused
+  rtosTaskReap();
+
+  // Allocate the stack, if the caller did not provide one
+  const bool stack_from_arena = (stack == NULL);
+  if (stack_from_arena) {
+    stack = rtosStackAlloc(stack_size);
+    if (stack == NULL) {
+      rtosExitCritical();
+      return RTOS_ERROR_RESOURCE;
+    }
+  }
+
   rtosTaskHandle_t tcb_ref = rtosPopTaskListHead(&rtos_inactive_tasks);
+  rtosExitCritical();
+
+  // Setup the tcb
+  tcb_ref->priority           = priority;
+  tcb_ref->base_priority      = priority;
+  tcb_ref->held_mutexes       = NULL;
+  tcb_ref->blocked_on         = NULL;
+  tcb_ref->wait_queue         = NULL;
+  tcb_ref->state              = RTOS_TASK_READY;
+  tcb_ref->stack_base         = (uint32_t) stack;
+  tcb_ref->stack_size         = stack_size;
+  tcb_ref->stack_from_arena   = stack_from_arena;
+  tcb_ref->stack_pointer      = tcb_ref->stack_base + stack_size;
+  tcb_ref->period_ticks       = period;
+  tcb_ref->deadline_ticks     = deadline;
+  tcb_ref->release_ticks      = rtosGetSysTickCount64();
+  tcb_ref->abs_deadline_ticks = tcb_ref->release_ticks + (deadline != 0 ? deadline : period);
+  tcb_ref->timeslice_ticks    = 0;
+  tcb_ref->quantum_ticks      = rtosGetTimeslice(tcb_ref);
+  tcb_ref->scheduler_lock     = 0;
+
+  tcb_ref->periodic_stats.jobs               = 0;
+  tcb_ref->periodic_stats.deadline_misses    = 0;
+  tcb_ref->periodic_stats.overruns           = 0;
+  tcb_ref->periodic_stats.max_lateness       = 0;
+  tcb_ref->periodic_stats.max_release_jitter = 0;
 
-  // Setup the tcb and add the task to the ready queue
-  tcb_ref->next          = NULL;
-  tcb_ref->priority      = priority;
-  tcb_ref->state         = RTOS_TASK_READY;
-  tcb_ref->stack_pointer = BASE_STACK_PTR - MAIN_STACK_SIZE - TASK_STACK_SIZE * tcb_ref->id;
-  rtosInsertTaskListHead(rtosGetReadyTaskQueue(priority), tcb_ref);
+  // Fill the stack, so that its usage can be measured and overflows detected
+  rtosStackFill(tcb_ref->stack_base, stack_size);
 
   // Initialize stack. Set all unspecified registers to 0. (Note: This is unnecessary)
   *(uint32_t*) (tcb_ref->stack_pointer - 0x40) = 0x00000000;       // R4
@@ -110,6 +332,11 @@ rtosStatus_t rtosTaskNew(rtosTaskFunc_t func, void* arg, rtosPriority_t priority
   *(uint32_t*) (tcb_ref->stack_pointer - 0x04) = 0x01000000;       // PSR
   tcb_ref->stack_pointer -= 0x40;
 
+  // Add the task to the ready queue
+  rtosEnterCritical();
+  rtosInsertReadyTaskHead(tcb_ref);
+  rtosExitCritical();
+
   if (task != NULL) {
     *task = tcb_ref;
   }
@@ -117,35 +344,297 @@ rtosStatus_t rtosTaskNew(rtosTaskFunc_t func, void* arg, rtosPriority_t priority
 }
 
 /**
- * Remove and return the head of the specified singly-linked list
+ * Delete the specified task
+ *
+ * The task is removed from its ready queue, or from the wait queue and timeout list it is blocked in, and gives up the
+ * mutexes it holds as described by rtosMutexReleaseAll(). Its task control block can be reused at once, so any other
+ * handles to the task become invalid. An arena stack is returned to the arena at once, unless the task deletes itself.
+ * It is still running on its stack until the context switch, so the stack is freed by the next rtosTaskCreate(), or
+ * the next time a task deletes itself.
+ *
+ * @param task  The task to delete. May be the running task, in which case the call does not return
+ *
+ * @return  - RTOS_OK               on success
+ *          - RTOS_ERROR_PARAMETER  if the task is NULL, is the idle task, or has already been deleted or exited
+ */
+rtosStatus_t rtosTaskDelete(rtosTaskHandle_t task) {
+  if (task == NULL || task == rtos_idle_task) {
+    return RTOS_ERROR_PARAMETER;
+  }
+
+  rtosEnterCritical();
+
+  if (task->state == RTOS_TASK_INACTIVE || task->state == RTOS_TASK_TERMINATED) {
+    rtosExitCritical();
+    return RTOS_ERROR_PARAMETER;
+  }
+
+  // Remove the task from every list it is in
+  if (task->state == RTOS_TASK_READY) {
+    rtosRemoveReadyTask(task);
+  } else {
+    rtosWaitQueueRemove(task);
+    rtosTimeoutRemove(task);
+  }
+
+  rtosMutexReleaseAll(task);
+
+  // Return the stack to the arena. A task deleting itself is still running on it, so it is freed later instead, which
+  // frees the stack of the previous such task now that it no longer runs
+  if (task->stack_from_arena) {
+    if (task == rtos_running_task) {
+      rtosTaskReap();
+      rtos_zombie_task = task;
+    } else {
+      rtosStackFree((void*) task->stack_base, task->stack_size);
+      task->stack_from_arena = false;
+    }
+  }
+
+  task->state = RTOS_TASK_TERMINATED;
+  rtosInsertTaskListTail(&rtos_inactive_tasks, task);
+
+  rtosExitCritical();
+  rtosInvokeScheduler();
+
+  return RTOS_OK;
+}
+
+/**
+ * Suspend the specified task until it is resumed with rtosTaskResume()
+ *
+ * A ready task is removed from its ready queue. A blocked task stops waiting: it is removed from the wait queue and
+ * timeout list it is in. Once it is resumed, its wait returns RTOS_ERROR rather than waiting again, since the object
+ * may have changed in the meantime, and its delay ends early. Mutexes held by the task stay held.
+ *
+ * @param task  The task to suspend. May be the running task, in which case the call returns once it is resumed
+ *
+ * @return  - RTOS_OK               on success
+ *          - RTOS_ERROR_PARAMETER  if the task is NULL, is the idle task, or has been deleted or exited
+ *          - RTOS_ERROR_RESOURCE   if the task is already suspended
+ */
+rtosStatus_t rtosTaskSuspend(rtosTaskHandle_t task) {
+  if (task == NULL || task == rtos_idle_task) {
+    return RTOS_ERROR_PARAMETER;
+  }
+
+  rtosEnterCritical();
+
+  switch (task->state) {
+    case RTOS_TASK_INACTIVE:
+    case RTOS_TASK_TERMINATED:
+      rtosExitCritical();
+      return RTOS_ERROR_PARAMETER;
+
+    case RTOS_TASK_SUSPENDED:
+      rtosExitCritical();
+      return RTOS_ERROR_RESOURCE;
+
+    case RTOS_TASK_READY:
+      rtosRemoveReadyTask(task);
+      break;
+
+    case RTOS_TASK_BLOCKED:
+    case RTOS_TASK_BLOCKED_TIMEOUT:
+      rtosWaitQueueRemove(task);
+      rtosTimeoutRemove(task);
+      rtosMutexCancelWait(task);
+      task->wake_status = RTOS_ERROR;
+      break;
+
+    case RTOS_TASK_RUNNING:
+      break;
+  }
+
+  task->state = RTOS_TASK_SUSPENDED;
+  rtosExitCritical();
+
+  // Only suspending the running task changes which task should run
+  if (task == rtos_running_task) {
+    rtosInvokeScheduler();
+  }
+
+  return RTOS_OK;
+}
+
+/**
+ * Resume the specified suspended task
+ *
+ * The task is appended to the ready queue of its priority.
+ *
+ * @return  - RTOS_OK               on success
+ *          - RTOS_ERROR_PARAMETER  if the task is NULL
+ *          - RTOS_ERROR_RESOURCE   if the task is not suspended
+ */
+rtosStatus_t rtosTaskResume(rtosTaskHandle_t task) {
+  if (task == NULL) {
+    return RTOS_ERROR_PARAMETER;
+  }
+
+  rtosEnterCritical();
+
+  if (task->state != RTOS_TASK_SUSPENDED) {
+    rtosExitCritical();
+    return RTOS_ERROR_RESOURCE;
+  }
+
+  task->state = RTOS_TASK_READY;
+  rtosInsertReadyTaskTail(task);
+  const bool preempt = (task->priority >= rtos_running_task->priority);
+
+  rtosExitCritical();
+
+  // Only a task of at least the running task's priority can take over from it
+  if (preempt) {
+    rtosInvokeScheduler();
+  }
+
+  return RTOS_OK;
+}
+
+/**
+ * Change the base priority of the specified task
+ *
+ * The task's effective priority is recomputed, so it keeps any higher priority it inherits through the mutexes it
+ * holds. A ready task is requeued at the tail of its new ready queue. A task in a priority-ordered wait queue is
+ * requeued behind the waiting tasks of its new priority. If the task is waiting on a priority-inheritance mutex, the
+ * change is propagated to the owner.
+ *
+ * @return  - RTOS_OK               on success
+ *          - RTOS_ERROR_PARAMETER  if the task is NULL or has been deleted or exited, or the priority is invalid
+ */
+rtosStatus_t rtosTaskSetPriority(rtosTaskHandle_t task, rtosPriority_t priority) {
+  if (task == NULL || priority < RTOS_PRIORITY_IDLE || priority > RTOS_PRIORITY_REALTIME) {
+    return RTOS_ERROR_PARAMETER;
+  }
+
+  rtosEnterCritical();
+
+  if (task->state == RTOS_TASK_INACTIVE || task->state == RTOS_TASK_TERMINATED) {
+    rtosExitCritical();
+    return RTOS_ERROR_PARAMETER;
+  }
+
+  const rtosPriority_t prev_priority = task->priority;
+  task->base_priority                = priority;
+  rtosMutexUpdatePriority(task);
+  const bool changed = (task->priority != prev_priority);
+
+  rtosExitCritical();
+
+  // Only a change in effective priority can change which task should run
+  if (changed) {
+    rtosInvokeScheduler();
+  }
+
+  return RTOS_OK;
+}
+
+/**
+ * Get the job statistics of the specified periodic task
+ *
+ * @param task  The task to query
+ * @param stats The structure to copy the statistics into
+ *
+ * @return  - RTOS_OK               on success
+ *          - RTOS_ERROR_PARAMETER  if the task or stats is NULL, or the task is not periodic
  */
-rtosTaskHandle_t rtosPopTaskListHead(rtosTaskHandle_t* list) {
-  rtosTaskHandle_t task = *list;
-  *list                 = (*list)->next;
-  task->next            = NULL;
+rtosStatus_t rtosTaskGetPeriodicStats(rtosTaskHandle_t task, rtosPeriodicStats_t* stats) {
+  if (task == NULL || stats == NULL || task->period_ticks == 0) {
+    return RTOS_ERROR_PARAMETER;
+  }
+
+  rtosEnterCritical();
+  *stats = task->periodic_stats;
+  rtosExitCritical();
+
+  return RTOS_OK;
+}
+
+/**
+ * Remove and return the head of the specified list
+ */
+rtosTaskHandle_t rtosPopTaskListHead(rtosTaskList_t* list) {
+  rtosTaskHandle_t task = list->head;
+  rtosRemoveTaskListItem(task);
   return task;
 }
 
 /**
- * Insert the specified task to the head of the specified singly-linked list
+ * Insert the specified task to the head of the specified list
  */
-void rtosInsertTaskListHead(rtosTaskHandle_t* list, rtosTaskHandle_t task) {
-  task->next = *list;
-  *list      = task;
+void rtosInsertTaskListHead(rtosTaskList_t* list, rtosTaskHandle_t task) {
+  task->list = list;
+  task->prev = NULL;
+  task->next = list->head;
+  if (list->head != NULL) {
+    list->head->prev = task;
+  } else {
+    list->tail = task;
+  }
+  list->head = task;
 }
 
 /**
- * Insert the specified task to the tail of the specified singly-linked list
+ * Insert the specified task to the tail of the specified list
  */
-void rtosInsertTaskListTail(rtosTaskHandle_t* list, rtosTaskHandle_t task) {
-  if (*list == NULL) {
-    *list = task;
+void rtosInsertTaskListTail(rtosTaskList_t* list, rtosTaskHandle_t task) {
+  task->list = list;
+  task->next = NULL;
+  task->prev = list->tail;
+  if (list->tail != NULL) {
+    list->tail->next = task;
   } else {
+    list->head = task;
+  }
+  list->tail = task;
+}
 
-    rtosTaskHandle_t cur = *list;
-    while (cur->next != NULL) {
-      cur = cur->next;
-    }
-    cur->next = task;
+/**
+ * Insert the specified task into the specified list, immediately before pos
+ *
+ * If pos is NULL, the task is inserted at the tail of the list.
+ */
+void rtosInsertTaskListBefore(rtosTaskList_t* list, rtosTaskHandle_t pos, rtosTaskHandle_t task) {
+  if (pos == NULL) {
+    rtosInsertTaskListTail(list, task);
+    return;
+  }
+
+  task->list = list;
+  task->next = pos;
+  task->prev = pos->prev;
+  if (pos->prev != NULL) {
+    pos->prev->next = task;
+  } else {
+    list->head = task;
   }
+  pos->prev = task;
+}
+
+/**
+ * Remove the specified task from whichever list it is in
+ *
+ * Does nothing if the task is not in a list.
+ */
+void rtosRemoveTaskListItem(rtosTaskHandle_t task) {
+  rtosTaskList_t* list = task->list;
+  if (list == NULL) {
+    return;
+  }
+
+  if (task->prev != NULL) {
+    task->prev->next = task->next;
+  } else {
+    list->head = task->next;
+  }
+  if (task->next != NULL) {
+    task->next->prev = task->prev;
+  } else {
+    list->tail = task->prev;
+  }
+
+  task->list = NULL;
+  task->next = NULL;
+  task->prev = NULL;
 }
@@ -6,6 +6,7 @@
 #ifndef __RTOS_TASK_H
 #define __RTOS_TASK_H
 
+#include <stdbool.h>
 #include <stdint.h>
 
 #include <LPC17xx.h>
@@ -13,10 +14,20 @@
 #include "status.h"
 
 #define BASE_STACK_PTR *(uint32_t*) (0x00 + SCB->VTOR)
-#define TOTAL_STACK_SIZE 0x2000
-#define MAIN_STACK_SIZE 0x800
+
+/// The number of task control blocks, including the idle task
+#ifndef MAX_TASKS
+#define MAX_TASKS 16
+#endif
+
+/// The stack size of tasks created without one, in bytes
 #define TASK_STACK_SIZE 0x400
-#define MAX_TASKS ((TOTAL_STACK_SIZE - MAIN_STACK_SIZE) / TASK_STACK_SIZE)
+
+/// The smallest permitted task stack, in bytes: the initial context plus room for an exception frame and a few calls
+#define TASK_STACK_MIN_SIZE 0x100
+
+/// The stack size of the idle task, in bytes
+#define IDLE_TASK_STACK_SIZE 0x100
 
 /// Task priorities
 typedef enum {
@@ -39,16 +50,56 @@ typedef enum {
   RTOS_TASK_BLOCKED,
   RTOS_TASK_BLOCKED_TIMEOUT,
   RTOS_TASK_TERMINATED,
+  RTOS_TASK_SUSPENDED,  ///< A task suspended while waiting gets RTOS_ERROR from its wait once it is resumed
 } rtosTaskState_t;
 
+/// Periodic task statistics
+typedef struct {
+  uint32_t jobs;                ///< The number of completed jobs
+  uint32_t deadline_misses;     ///< The number of jobs that completed after their deadline
+  uint32_t overruns;            ///< The number of jobs that completed after the release of the next job
+  uint32_t max_lateness;        ///< The latest that any job completed after its deadline, in ticks
+  uint32_t max_release_jitter;  ///< The longest delay between a job's release and the task resuming, in ticks
+} rtosPeriodicStats_t;
+
+/// Doubly-linked list of task control blocks, linked through the TCBs' next/prev fields
+typedef struct {
+  struct rtosTaskControlBlock_tag* head;
+  struct rtosTaskControlBlock_tag* tail;
+} rtosTaskList_t;
+
+struct rtosMutex_tag;
+struct rtosWaitQueue_tag;
+
 /// Task control block
 typedef struct rtosTaskControlBlock_tag {
   uint32_t                         id;
-  rtosPriority_t                   priority;
+  rtosPriority_t                   priority;            ///< The effective priority, including any inherited priority
+  rtosPriority_t                   base_priority;       ///< The priority assigned to the task, without inheritance
   rtosTaskState_t                  state;
   uint32_t                         stack_pointer;
-  uint32_t                         wake_time_ticks;
+  uint32_t                         stack_base;          ///< The lowest address of the task's stack
+  uint32_t                         stack_size;          ///< The size of the task's stack, in bytes
+  bool                             stack_from_arena;    ///< Whether the stack was allocated from the stack arena
+  rtosTicks_t                      wake_time_ticks;     ///< The tick at which the task's timeout expires, if any
+  rtosStatus_t                     wake_status;         ///< Why the task was last unblocked
+  void*                            wake_data;           ///< Data handed to the task when it was unblocked, if any
+  uint32_t                         timeslice_ticks;     ///< The round-robin timeslice, or 0 for the priority default
+  uint32_t                         quantum_ticks;       ///< The ticks remaining in the current timeslice
+  uint32_t                         scheduler_lock;      ///< The nesting depth of rtosSchedulerLock() by the task
+  uint32_t                         period_ticks;        ///< The release period, or 0 if the task is not periodic
+  uint32_t                         deadline_ticks;      ///< The EDF deadline relative to release, or 0 if none
+  rtosTicks_t                      release_ticks;       ///< The release time of the current job
+  rtosTicks_t                      abs_deadline_ticks;  ///< The current job's deadline, or else the next release
+  rtosPeriodicStats_t              periodic_stats;      ///< Job statistics, if the task is periodic
+  struct rtosMutex_tag*            held_mutexes;        ///< The mutexes currently held by the task
+  struct rtosMutex_tag*            blocked_on;          ///< The mutex the task is waiting to acquire, if any
+  struct rtosWaitQueue_tag*        wait_queue;          ///< The wait queue the task is blocked in, if any
+  rtosTaskList_t*                  list;                ///< The list the task is currently in, if any
   struct rtosTaskControlBlock_tag* next;
+  struct rtosTaskControlBlock_tag* prev;
+  struct rtosTaskControlBlock_tag* timeout_next;
+  struct rtosTaskControlBlock_tag* timeout_prev;
 } rtosTaskControlBlock_t;
 
 typedef rtosTaskControlBlock_t* rtosTaskHandle_t;
@@ -61,10 +112,40 @@ void rtosTaskInit(uint32_t task_id);
 void rtosTaskExit(void);
 
 rtosStatus_t rtosTaskNew(rtosTaskFunc_t func, void* arg, rtosPriority_t priority, rtosTaskHandle_t* task);
+rtosStatus_t rtosTaskNewStack(rtosTaskFunc_t    func,
+                              void*             arg,
+                              rtosPriority_t    priority,
+                              uint32_t          stack_size,
+                              void*             stack,
+                              rtosTaskHandle_t* task);
+rtosStatus_t rtosTaskNewDeadline(rtosTaskFunc_t    func,
+                                 void*             arg,
+                                 uint32_t          deadline,
+                                 uint32_t          period,
+                                 rtosTaskHandle_t* task);
+rtosStatus_t rtosTaskNewPeriodic(rtosTaskFunc_t    func,
+                                 void*             arg,
+                                 rtosPriority_t    priority,
+                                 uint32_t          period,
+                                 rtosTaskHandle_t* task);
+rtosStatus_t rtosTaskCreate(rtosTaskFunc_t    func,
+                            void*             arg,
+                            rtosPriority_t    priority,
+                            uint32_t          deadline,
+                            uint32_t          period,
+                            uint32_t          stack_size,
+                            void*             stack,
+                            rtosTaskHandle_t* task);
 rtosStatus_t rtosTaskDelete(rtosTaskHandle_t task);
+rtosStatus_t rtosTaskSuspend(rtosTaskHandle_t task);
+rtosStatus_t rtosTaskResume(rtosTaskHandle_t task);
+rtosStatus_t rtosTaskSetPriority(rtosTaskHandle_t task, rtosPriority_t priority);
+rtosStatus_t rtosTaskGetPeriodicStats(rtosTaskHandle_t task, rtosPeriodicStats_t* stats);
 
-rtosTaskHandle_t rtosPopTaskListHead(rtosTaskHandle_t* list);
-void             rtosInsertTaskListHead(rtosTaskHandle_t* list, rtosTaskHandle_t task);
-void             rtosInsertTaskListTail(rtosTaskHandle_t* list, rtosTaskHandle_t task);
+rtosTaskHandle_t rtosPopTaskListHead(rtosTaskList_t* list);
+void             rtosInsertTaskListHead(rtosTaskList_t* list, rtosTaskHandle_t task);
+void             rtosInsertTaskListTail(rtosTaskList_t* list, rtosTaskHandle_t task);
+void             rtosInsertTaskListBefore(rtosTaskList_t* list, rtosTaskHandle_t pos, rtosTaskHandle_t task);
+void             rtosRemoveTaskListItem(rtosTaskHandle_t task);
 
 #endif  // __RTOS_TASK_H
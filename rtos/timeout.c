@@ -0,0 +1,101 @@
+/**
+ * Timeout implementation
+ *
+ * Every task waiting on a timeout (delayed tasks and tasks in a timed wait on a semaphore or mutex) sits in a single
+ * list, ordered by wake time. A tick only ever touches the head of the list and the tasks that actually expire. Wake
+ * times are absolute 64-bit tick counts, so expiry is an ordered comparison that cannot wrap or be skipped past.
+ *
+ * @author Matt Reynolds
+ * @author Dawson Hemphill
+ */
+
+#include <stdlib.h>
+
+#include "globals.h"
+#include "timeout.h"
+
+rtosTaskHandle_t rtos_delayed_tasks = NULL;  // Stored in order of wake time
+
+/**
+ * Insert the specified task into the timeout list, to expire at the specified tick
+ *
+ * Tasks with equal wake times expire in the order they were inserted.
+ *
+ * @param task            The task to insert. Must not already be in the timeout list
+ * @param wake_time_ticks The tick at which the timeout expires
+ */
+void rtosTimeoutInsert(rtosTaskHandle_t task, rtosTicks_t wake_time_ticks) {
+
+  // Find the first task that expires after the new task
+  rtosTaskHandle_t prev = NULL;
+  rtosTaskHandle_t cur  = rtos_delayed_tasks;
+  while (cur != NULL && cur->wake_time_ticks <= wake_time_ticks) {
+    prev = cur;
+    cur  = cur->timeout_next;
+  }
+
+  // Link the task between prev and cur
+  task->wake_time_ticks = wake_time_ticks;
+  task->timeout_prev    = prev;
+  task->timeout_next    = cur;
+  if (cur != NULL) {
+    cur->timeout_prev = task;
+  }
+  if (prev != NULL) {
+    prev->timeout_next = task;
+  } else {
+    rtos_delayed_tasks = task;
+  }
+}
+
+/**
+ * Remove the specified task from the timeout list, cancelling its timeout
+ *
+ * Does nothing if the task is not in the timeout list.
+ */
+void rtosTimeoutRemove(rtosTaskHandle_t task) {
+  if (task->timeout_prev == NULL && rtos_delayed_tasks != task) {
+    return;
+  }
+
+  if (task->timeout_next != NULL) {
+    task->timeout_next->timeout_prev = task->timeout_prev;
+  }
+  if (task->timeout_prev != NULL) {
+    task->timeout_prev->timeout_next = task->timeout_next;
+  } else {
+    rtos_delayed_tasks = task->timeout_next;
+  }
+
+  task->timeout_prev = NULL;
+  task->timeout_next = NULL;
+}
+
+/**
+ * Expire every timeout whose wake time has been reached
+ *
+ * Every expired task is removed from the timeout list and, if it was in a timed wait, from the blocked list of the
+ * object it was waiting on, and is then made ready with a wake status of RTOS_ERROR_TIMEOUT.
+ */
+void rtosTimeoutTick(void) {
+  while (rtos_delayed_tasks != NULL && rtos_delayed_tasks->wake_time_ticks <= rtos_ticks) {
+    rtosUnblockTask(rtos_delayed_tasks, RTOS_ERROR_TIMEOUT);
+  }
+}
+
+/**
+ * Get the number of ticks until the earliest timeout expires
+ *
+ * @return The number of ticks, or RTOS_WAIT_FOREVER if there are no pending timeouts or the earliest is further away
+ */
+uint32_t rtosTimeoutNextExpiry(void) {
+  if (rtos_delayed_tasks == NULL) {
+    return RTOS_WAIT_FOREVER;
+  }
+  if (rtos_delayed_tasks->wake_time_ticks <= rtos_ticks) {
+    return 0;
+  }
+
+  const rtosTicks_t ticks = rtos_delayed_tasks->wake_time_ticks - rtos_ticks;
+  return (ticks < RTOS_WAIT_FOREVER) ? (uint32_t) ticks : RTOS_WAIT_FOREVER;
+}
@@ -0,0 +1,19 @@
+/**
+ * Timeouts
+ * @author Matt Reynolds
+ * @author Dawson Hemphill
+ */
+#ifndef __RTOS_TIMEOUT_H
+#define __RTOS_TIMEOUT_H
+
+#include <stdint.h>
+
+#include "task.h"
+
+void rtosTimeoutInsert(rtosTaskHandle_t task, rtosTicks_t wake_time_ticks);
+void rtosTimeoutRemove(rtosTaskHandle_t task);
+void rtosTimeoutTick(void);
+
+uint32_t rtosTimeoutNextExpiry(void);
+
+#endif  // __RTOS_TIMEOUT_H
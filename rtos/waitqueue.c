@@ -0,0 +1,106 @@
+/**
+ * Wait queue implementation
+ *
+ * A priority-ordered wait queue keeps its tasks in a single list, highest priority first, and remembers the last task
+ * of each priority. A new task is linked in after the last task of the lowest priority at or above its own, which is
+ * found from a bit vector of the waiting priorities with one CLZ. Insertion and removal are therefore O(1) regardless
+ * of the number of waiting tasks, and tasks of equal priority wake in FIFO order.
+ *
+ * @author Matt Reynolds
+ * @author Dawson Hemphill
+ */
+
+#include <stdlib.h>
+
+#include "waitqueue.h"
+
+/**
+ * Initialize the specified wait queue
+ *
+ * @param priority_ordered  If true, wake waiting tasks in order of priority. Otherwise, wake them in FIFO order
+ */
+void rtosWaitQueueInit(rtosWaitQueue_t* queue, bool priority_ordered) {
+  queue->list.head        = NULL;
+  queue->list.tail        = NULL;
+  queue->priority_ordered = priority_ordered;
+  queue->priorities       = 0;
+  for (uint32_t i = 0; i < RTOS_PRIORITY_COUNT; i++) {
+    queue->tails[i] = NULL;
+  }
+}
+
+/**
+ * Insert the specified task into the specified wait queue
+ *
+ * The task is placed after all waiting tasks of the same or higher priority, or at the tail if the queue is FIFO.
+ */
+void rtosWaitQueueInsert(rtosWaitQueue_t* queue, rtosTaskHandle_t task) {
+  task->wait_queue = queue;
+
+  if (!queue->priority_ordered) {
+    rtosInsertTaskListTail(&queue->list, task);
+    return;
+  }
+
+  const uint32_t bit = 1U << (task->priority - RTOS_PRIORITY_IDLE);
+
+  // Find the lowest waiting priority at or above the task's priority. The task is inserted after its last task
+  uint32_t at_or_above = queue->priorities & ~(bit - 1);
+  if (at_or_above == 0) {
+    rtosInsertTaskListHead(&queue->list, task);
+  } else {
+    uint32_t lowest_bit = at_or_above & (~at_or_above + 1);
+    uint32_t leading_zeros;
+    asm("CLZ leading_zeros, lowest_bit");
+    rtosInsertTaskListBefore(&queue->list, queue->tails[31 - leading_zeros]->next, task);
+  }
+
+  queue->tails[task->priority - RTOS_PRIORITY_IDLE] = task;
+  queue->priorities |= bit;
+}
+
+/**
+ * Remove the specified task from the wait queue it is in, if any
+ *
+ * The task's priority must not have changed since it was inserted.
+ */
+void rtosWaitQueueRemove(rtosTaskHandle_t task) {
+  rtosWaitQueue_t* queue = task->wait_queue;
+  if (queue == NULL) {
+    return;
+  }
+
+  if (queue->priority_ordered) {
+    const uint32_t index = task->priority - RTOS_PRIORITY_IDLE;
+    if (queue->tails[index] == task) {
+      if (task->prev != NULL && task->prev->priority == task->priority) {
+        queue->tails[index] = task->prev;
+      } else {
+        queue->tails[index] = NULL;
+        queue->priorities &= ~(1U << index);
+      }
+    }
+  }
+
+  rtosRemoveTaskListItem(task);
+  task->wait_queue = NULL;
+}
+
+/**
+ * Get the highest priority of the tasks in the specified wait queue
+ *
+ * @returns The priority, or RTOS_PRIORITY_NONE if the queue is empty
+ */
+rtosPriority_t rtosWaitQueueHighestPriority(rtosWaitQueue_t* queue) {
+  if (queue->priority_ordered) {
+    return (queue->list.head == NULL) ? RTOS_PRIORITY_NONE : queue->list.head->priority;
+  }
+
+  rtosPriority_t priority = RTOS_PRIORITY_NONE;
+  for (rtosTaskHandle_t task = queue->list.head; task != NULL; task = task->next) {
+    if (task->priority > priority) {
+      priority = task->priority;
+    }
+  }
+  return priority;
+}
@@ -0,0 +1,28 @@
+/**
+ * Wait queues
+ * @author Matt Reynolds
+ * @author Dawson Hemphill
+ */
+#ifndef __RTOS_WAITQUEUE_H
+#define __RTOS_WAITQUEUE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "task.h"
+
+/// The tasks blocked on a kernel object, in FIFO order or in order of effective priority
+typedef struct rtosWaitQueue_tag {
+  rtosTaskList_t   list;                        ///< The waiting tasks. The head is the next task to wake
+  bool             priority_ordered;            ///< If true, order by priority, and FIFO within a priority
+  uint32_t         priorities;                  ///< Bit (prio - IDLE) set iff a task of that priority is waiting
+  rtosTaskHandle_t tails[RTOS_PRIORITY_COUNT];  ///< The last waiting task of each priority, if priority-ordered
+} rtosWaitQueue_t;
+
+void rtosWaitQueueInit(rtosWaitQueue_t* queue, bool priority_ordered);
+void rtosWaitQueueInsert(rtosWaitQueue_t* queue, rtosTaskHandle_t task);
+void rtosWaitQueueRemove(rtosTaskHandle_t task);
+
+rtosPriority_t rtosWaitQueueHighestPriority(rtosWaitQueue_t* queue);
+
+#endif  // __RTOS_WAITQUEUE_H
@@ -22,6 +22,8 @@
 //#include "type.h"
 #include "uart.h"
 
+#include "../rtos/rtos.h"
+
 //#ifdef __DBG_ITM
 volatile int ITM_RxBuffer = ITM_RXBUFFER_EMPTY; /*  CMSIS Debug Input        */
 //#endif
@@ -31,6 +33,9 @@ volatile uint8_t  UART0TxEmpty = 1, UART1TxEmpty = 1;
 volatile uint8_t  UART0Buffer[BUFSIZE], UART1Buffer[BUFSIZE];
 volatile uint32_t UART0Count = 0, UART1Count = 0;
 
+// Released by the receive ISRs so that UARTRecieve can sleep rather than busy-wait
+rtosSemaphore_t UART0RxSem, UART1RxSem;
+
 volatile uint8_t RcvLock0;
 volatile uint8_t SndLock0;
 
@@ -103,6 +108,7 @@ void UART0_IRQHandler(void) {
     /* Note: read RBR will clear the interrupt */
     UART0Buffer[UART0Count] = LPC_UART0->RBR;
     UART0Count++;
+    rtosSemaphoreReleaseFromISR(&UART0RxSem);
     if (UART0Count == BUFSIZE) {
       UART0Count = 0; /* buffer overflow */
     }
@@ -147,6 +153,7 @@ void UART1_IRQHandler(void) {
     /* Note: read RBR will clear the interrupt */
     UART1Buffer[UART1Count] = LPC_UART1->RBR;
     UART1Count++;
+    rtosSemaphoreReleaseFromISR(&UART1RxSem);
     if (UART1Count == BUFSIZE) {
       UART0Count = 0; /* buffer overflow */
     }
@@ -206,6 +213,8 @@ uint32_t UARTInit(uint32_t PortNum, uint32_t baudrate) {
   uint32_t Fdiv;
   uint32_t pclk;
 
+  rtosSemaphoreAttr_t rx_sem_attrs = {"uart_rx"};
+
   if (PortNum == 0) {
     LPC_PINCON->PINSEL0 &= ~0x000000F0;
     LPC_PINCON->PINSEL0 |= 0x00000050; /* RxD0 is P0.3 and TxD0 is P0.2 */
@@ -222,6 +231,7 @@ uint32_t UARTInit(uint32_t PortNum, uint32_t baudrate) {
     LPC_UART0->LCR = 0x03; /* DLAB = 0 */
     LPC_UART0->FCR = 0x07; /* Enable and reset TX and RX FIFO. */
 
+    rtosSemaphoreNew(1, 0, &rx_sem_attrs, &UART0RxSem);
     NVIC_EnableIRQ(UART0_IRQn);
 
     // LPC_UART0->IER = IER_RBR | IER_THRE | IER_RLS; /* Enable UART0 interrupt */
@@ -248,6 +258,7 @@ uint32_t UARTInit(uint32_t PortNum, uint32_t baudrate) {
     LPC_UART1->LCR = 0x03; /* DLAB = 0 */
     LPC_UART1->FCR = 0x07; /* Enable and reset TX and RX FIFO. */
 
+    rtosSemaphoreNew(1, 0, &rx_sem_attrs, &UART1RxSem);
     NVIC_EnableIRQ(UART1_IRQn);
 
     // LPC_UART1->IER = IER_RBR | IER_THRE | IER_RLS; /* Enable UART1 interrupt */
@@ -354,10 +365,12 @@ uint32_t UARTRecieve(uint32_t portNum, uint8_t* BufferPtr, uint32_t Length) {
   // Enable interupt
   LPC_UART->IER |= IER_RBR;
 
-  // busy waiting
-
-  while (*UARTCount == 0)
-    ;
+  // Sleep until the receive ISR signals that data has arrived. Busy-wait if the RTOS has not started yet
+  while (*UARTCount == 0) {
+    if (rtos_running_task) {
+      rtosSemaphoreAcquire(portNum == 0 ? &UART0RxSem : &UART1RxSem, RTOS_WAIT_FOREVER);
+    }
+  }
 
 
   // This part has to be put in the critical section
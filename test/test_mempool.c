@@ -0,0 +1,103 @@
+/**
+ * test_mempool.c
+ *
+ * Test blocking allocation from a fixed-block memory pool, with blocks handed from a producer to a consumer. The
+ * consumer frees every other block from an ISR pended in software, at the most urgent priority
+ */
+#if TEST_MEMPOOL
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <LPC17xx.h>
+
+#include "../rtos/rtos.h"
+
+#define NUM_BLOCKS 4
+
+typedef struct {
+  uint32_t sequence;
+  uint32_t ticks;
+} message_t;
+
+// The pool storage, in the AHB SRAM bank
+RTOS_AHB_SRAM uint32_t pool_mem[RTOS_MEMPOOL_MEM_SIZE(NUM_BLOCKS, sizeof(message_t)) / sizeof(uint32_t)];
+
+rtosMemPool_t   pool;
+rtosSemaphore_t full_sem;
+message_t*      messages[NUM_BLOCKS];
+uint32_t        head = 0;
+uint32_t        tail = 0;
+
+// The block for the timer ISR to free, and the status the free returned
+void* volatile        isr_block  = NULL;
+volatile rtosStatus_t isr_status = RTOS_OK;
+
+void TIMER0_IRQHandler(void) {
+  isr_status = rtosMemPoolFreeFromISR(&pool, isr_block);
+}
+
+void task_producer(void* arg) {
+  for (uint32_t sequence = 0; true; sequence++) {
+
+    // The consumer frees blocks more slowly than they are produced, so the producer blocks once the pool is empty
+    void*        block;
+    rtosStatus_t stat = rtosMemPoolAlloc(&pool, 500, &block);
+    if (stat != RTOS_OK) {
+      printf("Producer: Allocation returned %s\n",
+             stat == RTOS_ERROR_TIMEOUT ? "RTOS_ERROR_TIMEOUT" : "unexpected status");
+      continue;
+    }
+
+    message_t* message = (message_t*) block;
+    message->sequence  = sequence;
+    message->ticks     = rtosGetSysTickCount();
+    printf("Producer: Sent message %d in block %p\n", message->sequence, block);
+
+    messages[head++ % NUM_BLOCKS] = message;
+    rtosSemaphoreRelease(&full_sem);
+  }
+}
+
+void task_consumer(void* arg) {
+  while (true) {
+    rtosSemaphoreAcquire(&full_sem, RTOS_WAIT_FOREVER);
+    message_t* message = messages[tail++ % NUM_BLOCKS];
+    printf("Consumer: Received message %d after %d ticks\n", message->sequence, rtosGetSysTickCount() - message->ticks);
+
+    // Free odd-numbered messages from the ISR, which runs as soon as it is pended, and the rest from the task
+    if (message->sequence % 2 == 1) {
+      isr_block = message;
+      NVIC_SetPendingIRQ(TIMER0_IRQn);
+      printf("Consumer: Freed block %p from ISR, which returned %s\n", (void*) message,
+             isr_status == RTOS_OK ? "RTOS_OK" : "an error");
+    } else {
+      rtosMemPoolFree(&pool, message);
+    }
+    rtosDelay(200);
+  }
+}
+
+int main(void) {
+  printf("\n\n\n\n\n");
+
+  rtosInitialize();
+
+  rtosMemPoolAttr_t pool_attributes = {"", 0, pool_mem, sizeof(pool_mem)};
+  rtosMemPoolNew(NUM_BLOCKS, sizeof(message_t), &pool_attributes, &pool);
+
+  rtosSemaphoreAttr_t sem_attributes = {""};
+  rtosSemaphoreNew(NUM_BLOCKS, 0, &sem_attributes, &full_sem);
+
+  // Run the ISR at the most urgent priority, which no critical section masks
+  NVIC_SetPriority(TIMER0_IRQn, 0);
+  NVIC_EnableIRQ(TIMER0_IRQn);
+
+  rtosTaskNew(task_producer, NULL, RTOS_PRIORITY_NORMAL, NULL);
+  rtosTaskNew(task_consumer, NULL, RTOS_PRIORITY_NORMAL, NULL);
+
+  rtosBegin();
+}
+
+#endif
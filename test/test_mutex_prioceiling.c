@@ -0,0 +1,74 @@
+/**
+ * test_mutex_prioceiling.c
+ *
+ * Test immediate priority-ceiling mutexes
+ */
+#if TEST_MUTEX_PRIOCEILING
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../rtos/rtos.h"
+
+rtosMutex_t      mutex;
+rtosTaskHandle_t tcb1;
+rtosTaskHandle_t tcb2;
+rtosTaskHandle_t tcb3;
+
+void task1(void* arg) {
+
+  rtosDelay(1000);
+
+  printf("High priority task: Attempting acquire mutex...\n");
+  rtosMutexAcquire(&mutex, RTOS_WAIT_FOREVER);
+  printf("High priority task: Acquired mutex!\n");
+
+  rtosMutexRelease(&mutex);
+  printf("High priority task: Released mutex!\n");
+  rtosTaskExit();
+}
+
+void task2(void* arg) {
+
+  rtosDelay(500);
+
+  printf("Med  priority task: Starting long task...\n");
+  while (true) {
+  }
+}
+
+void task3(void* arg) {
+
+  rtosMutexAcquire(&mutex, RTOS_WAIT_FOREVER);
+  printf("Low  priority task: Acquired mutex, priority raised to %d\n", tcb3->priority);
+
+  // The medium-prio task is released during this loop, but must not preempt the ceiling
+  printf("Low  priority task: Starting long task...\n");
+  uint32_t i = 0;
+  while (i < 50000000) {
+    i++;
+  }
+  printf("Low  priority task: Finished long task!\n");
+
+  rtosMutexRelease(&mutex);
+  printf("Low  priority task: Released mutex, priority restored to %d\n", tcb3->priority);
+  rtosTaskExit();
+}
+
+int main(void) {
+  printf("\n\n\n\n\n");
+
+  rtosInitialize();
+  rtosTaskNew(task1, NULL, RTOS_PRIORITY_ABOVE_NORMAL, &tcb1);  // High prio
+  rtosTaskNew(task2, NULL, RTOS_PRIORITY_NORMAL, &tcb2);        // Med prio
+  rtosTaskNew(task3, NULL, RTOS_PRIORITY_LOW, &tcb3);           // Low prio
+
+  // The ceiling is the priority of the highest-priority task that uses the mutex
+  rtosMutexAttr_t attributes = {"", RTOS_MUTEX_PRIO_CEILING, RTOS_PRIORITY_ABOVE_NORMAL};
+  rtosMutexNew(&attributes, &mutex);
+
+  rtosBegin();
+}
+
+#endif
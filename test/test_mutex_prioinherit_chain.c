@@ -0,0 +1,93 @@
+/**
+ * test_mutex_prioinherit_chain.c
+ *
+ * Test transitive mutex priority inheritance through a chain of owners
+ */
+#if TEST_MUTEX_PRIOINHERIT_CHAIN
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../rtos/rtos.h"
+
+rtosMutex_t      mutex_a;
+rtosMutex_t      mutex_b;
+rtosTaskHandle_t tcb_high;
+rtosTaskHandle_t tcb_spin;
+rtosTaskHandle_t tcb_mid;
+rtosTaskHandle_t tcb_low;
+
+void taskHigh(void* arg) {
+
+  rtosDelay(1000);
+
+  printf("High priority task: Attempting acquire mutex B...\n");
+  rtosMutexAcquire(&mutex_b, RTOS_WAIT_FOREVER);
+  printf("High priority task: Acquired mutex B!\n");
+
+  rtosMutexRelease(&mutex_b);
+  printf("High priority task: Released mutex B!\n");
+  rtosTaskExit();
+}
+
+void taskSpin(void* arg) {
+
+  rtosDelay(750);
+
+  printf("Med  priority task: Starting long task...\n");
+  while (true) {
+  }
+}
+
+void taskMid(void* arg) {
+
+  rtosDelay(250);
+
+  rtosMutexAcquire(&mutex_b, RTOS_WAIT_FOREVER);
+  printf("Mid  priority task: Acquired mutex B, attempting acquire mutex A...\n");
+  rtosMutexAcquire(&mutex_a, RTOS_WAIT_FOREVER);
+  printf("Mid  priority task: Acquired mutex A, priority %d\n", tcb_mid->priority);
+
+  rtosMutexRelease(&mutex_a);
+  rtosMutexRelease(&mutex_b);
+  printf("Mid  priority task: Released mutexes, priority %d\n", tcb_mid->priority);
+  rtosTaskExit();
+}
+
+void taskLow(void* arg) {
+
+  rtosMutexAcquire(&mutex_a, RTOS_WAIT_FOREVER);
+  printf("Low  priority task: Acquired mutex A\n");
+
+  printf("Low  priority task: Starting long task...\n");
+  uint32_t i = 0;
+  while (i < 50000000) {
+    i++;
+  }
+  printf("Low  priority task: Finished long task with priority %d\n", tcb_low->priority);
+
+  rtosMutexRelease(&mutex_a);
+  printf("Low  priority task: Released mutex A, priority %d\n", tcb_low->priority);
+  rtosTaskExit();
+}
+
+int main(void) {
+  printf("\n\n\n\n\n");
+
+  rtosInitialize();
+  rtosTaskNew(taskHigh, NULL, RTOS_PRIORITY_ABOVE_NORMAL, &tcb_high);
+  rtosTaskNew(taskSpin, NULL, RTOS_PRIORITY_NORMAL, &tcb_spin);
+  rtosTaskNew(taskMid, NULL, RTOS_PRIORITY_BELOW_NORMAL, &tcb_mid);
+  rtosTaskNew(taskLow, NULL, RTOS_PRIORITY_LOW, &tcb_low);
+
+  // The high-prio task blocks on B, held by the mid-prio task, which is blocked on A, held by the low-prio task.
+  // The boost must reach the low-prio task, or the spinning task starves the whole chain
+  rtosMutexAttr_t attributes = {"", RTOS_MUTEX_PRIO_INHERIT};
+  rtosMutexNew(&attributes, &mutex_a);
+  rtosMutexNew(&attributes, &mutex_b);
+
+  rtosBegin();
+}
+
+#endif
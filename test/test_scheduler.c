@@ -16,7 +16,7 @@ rtosMutex_t print_mutex;
 void task(void* arg) {
   uint32_t task_id = (uint32_t) arg;
 
-  uint32_t       last_time = rtosGetSysTickCount();
+  rtosTicks_t    last_time = rtosGetSysTickCount64();
   const uint32_t step      = 100 * task_id;
 
   while (true) {
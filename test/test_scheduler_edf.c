@@ -0,0 +1,81 @@
+/**
+ * test_scheduler_edf.c
+ *
+ * Test earliest-deadline-first scheduling with a task set that is schedulable under EDF but not under rate-monotonic
+ * priority assignment (total utilization 0.9)
+ */
+#if TEST_SCHEDULER_EDF
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../rtos/rtos.h"
+
+typedef struct {
+  uint32_t id;
+  uint32_t exec_ticks;
+  uint32_t deadline;
+  uint32_t period;
+} job_t;
+
+rtosMutex_t print_mutex;
+
+job_t job1 = {1, 40, 100, 100};
+job_t job2 = {2, 75, 150, 150};
+
+/**
+ * Spin for the specified number of ticks of execution time. Ticks during which the task was preempted are not counted.
+ */
+void busy(uint32_t ticks) {
+  uint32_t last = rtosGetSysTickCount();
+  while (ticks > 0) {
+    uint32_t now = rtosGetSysTickCount();
+    if (now - last == 1) {
+      ticks--;
+    }
+    last = now;
+  }
+}
+
+void task(void* arg) {
+  job_t* job = (job_t*) arg;
+
+  uint32_t release = rtosGetSysTickCount();
+  uint32_t misses  = 0;
+
+  while (true) {
+    busy(job->exec_ticks);
+
+    uint32_t finish = rtosGetSysTickCount();
+    if (finish - release > job->deadline) {
+      misses++;
+    }
+
+    rtosMutexAcquire(&print_mutex, RTOS_WAIT_FOREVER);
+    printf("%d\tTask %d: job finished %d ticks after release, %d misses\n",
+           finish,
+           job->id,
+           finish - release,
+           misses);
+    rtosMutexRelease(&print_mutex);
+
+    rtosWaitForNextPeriod();
+    release += job->period;
+  }
+}
+
+int main(void) {
+  printf("\n\n\n\n\n");
+
+  rtosInitialize();
+  rtosTaskNewDeadline(task, &job1, job1.deadline, job1.period, NULL);
+  rtosTaskNewDeadline(task, &job2, job2.deadline, job2.period, NULL);
+
+  rtosMutexAttr_t attributes = {"", RTOS_MUTEX_PRIO_INHERIT};
+  rtosMutexNew(&attributes, &print_mutex);
+
+  rtosBegin();
+}
+
+#endif
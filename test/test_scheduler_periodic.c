@@ -0,0 +1,68 @@
+/**
+ * test_scheduler_periodic.c
+ *
+ * Test periodic tasks by printing the job statistics of each task. The low priority task periodically takes longer
+ * than its period, so it should report deadline misses and overruns.
+ */
+#if TEST_SCHEDULER_PERIODIC
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../rtos/rtos.h"
+
+#define NUM_PERIODIC 3
+
+rtosTaskHandle_t periodic_tasks[NUM_PERIODIC];
+
+void task_periodic(void* arg) {
+  const uint32_t task_id = (uint32_t) arg;
+  uint32_t       job     = 0;
+
+  while (true) {
+
+    // Every tenth job of the lowest priority task runs for longer than its period
+    uint32_t busy_ticks = (task_id == NUM_PERIODIC - 1 && job % 10 == 0) ? 150 : 10;
+    uint32_t start      = rtosGetSysTickCount();
+    while (rtosGetSysTickCount() - start < busy_ticks) {
+    }
+
+    job++;
+    rtosWaitForNextPeriod();
+  }
+}
+
+void task_monitor(void* arg) {
+  rtosPeriodicStats_t stats;
+
+  while (true) {
+    rtosDelay(rtosGetSysTickFreq());
+
+    for (uint32_t task_id = 0; task_id < NUM_PERIODIC; task_id++) {
+      rtosTaskGetPeriodicStats(periodic_tasks[task_id], &stats);
+      printf("Task %d: %d jobs, %d misses, %d overruns, max lateness %d, max jitter %d\n",
+             task_id,
+             stats.jobs,
+             stats.deadline_misses,
+             stats.overruns,
+             stats.max_lateness,
+             stats.max_release_jitter);
+    }
+    printf("\n");
+  }
+}
+
+int main(void) {
+  printf("\n\n\n\n\n");
+
+  rtosInitialize();
+  rtosTaskNewPeriodic(task_periodic, (void*) 0, RTOS_PRIORITY_ABOVE_NORMAL, 50, &periodic_tasks[0]);
+  rtosTaskNewPeriodic(task_periodic, (void*) 1, RTOS_PRIORITY_NORMAL, 100, &periodic_tasks[1]);
+  rtosTaskNewPeriodic(task_periodic, (void*) 2, RTOS_PRIORITY_BELOW_NORMAL, 100, &periodic_tasks[2]);
+  rtosTaskNew(task_monitor, NULL, RTOS_PRIORITY_HIGH, NULL);
+
+  rtosBegin();
+}
+
+#endif
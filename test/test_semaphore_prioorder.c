@@ -0,0 +1,64 @@
+/**
+ * test_semaphore_prioorder.c
+ *
+ * Test priority-ordered semaphore wait queues
+ */
+#if TEST_SEMAPHORE_PRIOORDER
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../rtos/rtos.h"
+
+rtosSemaphore_t  semaphore;
+rtosTaskHandle_t tcb_release;
+rtosTaskHandle_t tcb1;
+rtosTaskHandle_t tcb2;
+rtosTaskHandle_t tcb3;
+rtosTaskHandle_t tcb4;
+
+void waiter(void* arg) {
+  const char* name = (const char*) arg;
+
+  // Block in order of increasing priority, so that FIFO order would be the reverse of priority order
+  rtosDelay(100 * rtos_running_task->priority);
+
+  printf("%s: Attempting acquire semaphore...\n", name);
+  rtosSemaphoreAcquire(&semaphore, RTOS_WAIT_FOREVER);
+  printf("%s: Acquired semaphore!\n", name);
+
+  rtosTaskExit();
+}
+
+void releaser(void* arg) {
+
+  // Wait for every waiter to block
+  rtosDelay(1000);
+
+  // The waiters should acquire in order of priority: high, normal, then the two low tasks in the order they queued
+  for (uint32_t i = 0; i < 4; i++) {
+    rtosSemaphoreRelease(&semaphore);
+    rtosDelay(100);
+  }
+
+  rtosTaskExit();
+}
+
+int main(void) {
+  printf("\n\n\n\n\n");
+
+  rtosInitialize();
+  rtosTaskNew(releaser, NULL, RTOS_PRIORITY_REALTIME, &tcb_release);
+  rtosTaskNew(waiter, "High   priority task", RTOS_PRIORITY_ABOVE_NORMAL, &tcb1);
+  rtosTaskNew(waiter, "Normal priority task", RTOS_PRIORITY_NORMAL, &tcb2);
+  rtosTaskNew(waiter, "Low    priority task 1", RTOS_PRIORITY_LOW, &tcb3);
+  rtosTaskNew(waiter, "Low    priority task 2", RTOS_PRIORITY_LOW, &tcb4);
+
+  rtosSemaphoreAttr_t attributes = {"", RTOS_SEMAPHORE_PRIO_ORDER};
+  rtosSemaphoreNew(4, 0, &attributes, &semaphore);
+
+  rtosBegin();
+}
+
+#endif
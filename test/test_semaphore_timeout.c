@@ -0,0 +1,69 @@
+/**
+ * test_semaphore_timeout.c
+ *
+ * Test timed semaphore waits and waits on deleted semaphores
+ */
+#if TEST_SEMAPHORE_TIMEOUT
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../rtos/rtos.h"
+
+rtosSemaphore_t  timeout_sem;
+rtosSemaphore_t  deleted_sem;
+rtosTaskHandle_t tcb1;
+rtosTaskHandle_t tcb2;
+rtosTaskHandle_t tcb3;
+
+void task1(void* arg) {
+
+  // Nothing releases this semaphore, so the wait should time out after 500 ticks
+  printf("Timeout task: Attempting acquire semaphore for 500 ticks...\n");
+  const rtosTicks_t start = rtosGetSysTickCount64();
+  rtosStatus_t      stat  = rtosSemaphoreAcquire(&timeout_sem, 500);
+  const rtosTicks_t end   = rtosGetSysTickCount64();
+  printf("Timeout task: Returned %s after %u ticks\n",
+         stat == RTOS_ERROR_TIMEOUT ? "RTOS_ERROR_TIMEOUT" : "unexpected status",
+         (uint32_t)(end - start));
+
+  rtosTaskExit();
+}
+
+void task2(void* arg) {
+
+  // This semaphore is deleted while the task waits, so the wait should fail
+  printf("Delete task: Attempting acquire semaphore forever...\n");
+  rtosStatus_t stat = rtosSemaphoreAcquire(&deleted_sem, RTOS_WAIT_FOREVER);
+  printf("Delete task: Returned %s\n", stat == RTOS_ERROR ? "RTOS_ERROR" : "unexpected status");
+
+  rtosTaskExit();
+}
+
+void task3(void* arg) {
+
+  rtosDelay(1000);
+
+  printf("Deleter task: Deleting semaphore...\n");
+  rtosSemaphoreDelete(&deleted_sem);
+
+  rtosTaskExit();
+}
+
+int main(void) {
+  printf("\n\n\n\n\n");
+
+  rtosInitialize();
+  rtosTaskNew(task1, NULL, RTOS_PRIORITY_NORMAL, &tcb1);
+  rtosTaskNew(task2, NULL, RTOS_PRIORITY_NORMAL, &tcb2);
+  rtosTaskNew(task3, NULL, RTOS_PRIORITY_LOW, &tcb3);
+
+  rtosSemaphoreAttr_t attributes = {""};
+  rtosSemaphoreNew(1, 0, &attributes, &timeout_sem);
+  rtosSemaphoreNew(1, 0, &attributes, &deleted_sem);
+
+  rtosBegin();
+}
+
+#endif
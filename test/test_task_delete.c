@@ -0,0 +1,76 @@
+/**
+ * test_task_delete.c
+ *
+ * Test deleting tasks that hold mutexes, and that deleted tasks' control blocks and stacks are reused
+ */
+#if TEST_TASK_DELETE
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../rtos/rtos.h"
+
+// More workers than task control blocks, so the workers only fit if deleted tasks are reclaimed
+#define NUM_WORKERS (2 * MAX_TASKS)
+
+rtosMutex_t robust_mutex;
+rtosMutex_t plain_mutex;
+
+void task_worker(void* arg) {
+  rtosMutexAcquire(&robust_mutex, RTOS_WAIT_FOREVER);
+  rtosMutexAcquire(&plain_mutex, 0);
+
+  // Hold the mutexes until deleted
+  while (true) {
+    rtosDelay(1000);
+  }
+}
+
+void task_supervisor(void* arg) {
+  const uint32_t arena_free = rtosStackArenaFree();
+
+  for (uint32_t worker_id = 0; worker_id < NUM_WORKERS; worker_id++) {
+    rtosTaskHandle_t worker;
+    if (rtosTaskNew(task_worker, NULL, RTOS_PRIORITY_HIGH, &worker) != RTOS_OK) {
+      printf("Supervisor: Could not create worker %d\n", worker_id);
+      break;
+    }
+
+    // Let the worker acquire the mutexes, then delete it while it holds them
+    rtosDelay(10);
+    rtosTaskDelete(worker);
+
+    // The robust mutex is released by the deletion and reports its owner died, but the plain mutex is abandoned
+    rtosStatus_t robust_stat = rtosMutexAcquire(&robust_mutex, 0);
+    rtosStatus_t plain_stat  = rtosMutexAcquire(&plain_mutex, 0);
+    printf("Supervisor: Deleted worker %d. Robust mutex: %s, plain mutex: %s, %d bytes free in arena (%d before)\n",
+           worker_id,
+           robust_stat == RTOS_ERROR_OWNER_DIED ? "RTOS_ERROR_OWNER_DIED" : "unexpected status",
+           plain_stat == RTOS_ERROR ? "RTOS_ERROR" : "unexpected status",
+           rtosStackArenaFree(),
+           arena_free);
+    if (robust_stat == RTOS_ERROR_OWNER_DIED) {
+      rtosMutexRelease(&robust_mutex);
+    }
+  }
+
+  rtosTaskExit();
+}
+
+int main(void) {
+  printf("\n\n\n\n\n");
+
+  rtosInitialize();
+
+  rtosMutexAttr_t robust_attributes = {"", RTOS_MUTEX_ROBUST};
+  rtosMutexAttr_t plain_attributes  = {""};
+  rtosMutexNew(&robust_attributes, &robust_mutex);
+  rtosMutexNew(&plain_attributes, &plain_mutex);
+
+  rtosTaskNew(task_supervisor, NULL, RTOS_PRIORITY_NORMAL, NULL);
+
+  rtosBegin();
+}
+
+#endif
@@ -0,0 +1,60 @@
+/**
+ * test_task_stack.c
+ *
+ * Test tasks with variable-size stacks, allocated from the stack arena or provided by the caller, and report how much
+ * of each stack is used
+ */
+#if TEST_TASK_STACK
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../rtos/rtos.h"
+
+#define NUM_BLINKERS 8
+
+// A caller-provided stack, for a task that needs more than the default
+__attribute__((aligned(RTOS_STACK_ALIGN))) uint8_t large_stack[0x800];
+
+void task_blink(void* arg) {
+  const uint32_t task_id = (uint32_t) arg;
+
+  while (true) {
+    rtosDelay(100 * (task_id + 1));
+    rtosStackUsage_t usage;
+    rtosTaskGetStackUsage(rtos_running_task, &usage);
+    printf("Blinker %d: stack %d bytes, %d used, %d max\n", task_id, usage.size, usage.used, usage.max_used);
+  }
+}
+
+void task_large(void* arg) {
+  while (true) {
+    rtosDelay(1000);
+    rtosStackUsage_t usage;
+    rtosTaskGetStackUsage(rtos_running_task, &usage);
+    printf("Large task: stack %d bytes, %d max used, %d bytes free in arena\n", usage.size, usage.max_used,
+           rtosStackArenaFree());
+  }
+}
+
+int main(void) {
+  printf("\n\n\n\n\n");
+
+  rtosInitialize();
+
+  // Small stacks from the arena, taking 5 KiB rather than the 8 KiB the blinkers would need at the default stack size
+  for (uint32_t task_id = 0; task_id < NUM_BLINKERS; task_id++) {
+    rtosTaskNewStack(task_blink, (void*) task_id, RTOS_PRIORITY_NORMAL, 0x280, NULL, NULL);
+  }
+
+  // The blinkers' stacks are already in the arena, so a stack the size of the whole arena cannot be allocated
+  rtosStatus_t stat = rtosTaskNewStack(task_blink, NULL, RTOS_PRIORITY_NORMAL, RTOS_STACK_ARENA_SIZE, NULL, NULL);
+  printf("Main: Creating a task with a %d byte stack returned %s, with %d bytes free in arena\n", RTOS_STACK_ARENA_SIZE,
+         stat == RTOS_ERROR_RESOURCE ? "RTOS_ERROR_RESOURCE" : "unexpected status", rtosStackArenaFree());
+  rtosTaskNewStack(task_large, NULL, RTOS_PRIORITY_NORMAL, sizeof(large_stack), large_stack, NULL);
+
+  rtosBegin();
+}
+
+#endif
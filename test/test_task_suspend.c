@@ -0,0 +1,62 @@
+/**
+ * test_task_suspend.c
+ *
+ * Test suspending and resuming tasks, and changing task priorities at runtime
+ */
+#if TEST_TASK_SUSPEND
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../rtos/rtos.h"
+
+rtosTaskHandle_t tcb_critical;
+rtosTaskHandle_t tcb_background;
+
+void task_critical(void* arg) {
+  while (true) {
+    printf("Critical task: Running at priority %d\n", rtos_running_task->priority);
+    rtosDelay(250);
+  }
+}
+
+void task_background(void* arg) {
+  while (true) {
+    printf("Background task: Running at priority %d\n", rtos_running_task->priority);
+    rtosDelay(250);
+  }
+}
+
+void task_controller(void* arg) {
+  while (true) {
+    rtosDelay(1000);
+
+    // Shed load: demote the critical task and park the background task
+    printf("Controller: Demoting critical task and suspending background task\n");
+    rtosTaskSetPriority(tcb_critical, RTOS_PRIORITY_LOW);
+    rtosTaskSuspend(tcb_background);
+    printf("Controller: Suspending again returned %s\n",
+           rtosTaskSuspend(tcb_background) == RTOS_ERROR_RESOURCE ? "RTOS_ERROR_RESOURCE" : "unexpected status");
+
+    rtosDelay(1000);
+
+    // Restore both tasks
+    printf("Controller: Restoring critical task and resuming background task\n");
+    rtosTaskSetPriority(tcb_critical, RTOS_PRIORITY_ABOVE_NORMAL);
+    rtosTaskResume(tcb_background);
+  }
+}
+
+int main(void) {
+  printf("\n\n\n\n\n");
+
+  rtosInitialize();
+  rtosTaskNew(task_critical, NULL, RTOS_PRIORITY_ABOVE_NORMAL, &tcb_critical);
+  rtosTaskNew(task_background, NULL, RTOS_PRIORITY_NORMAL, &tcb_background);
+  rtosTaskNew(task_controller, NULL, RTOS_PRIORITY_HIGH, NULL);
+
+  rtosBegin();
+}
+
+#endif